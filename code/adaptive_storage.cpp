@@ -0,0 +1,136 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "adaptive_storage.hpp"
+#include "allocations.hpp"
+#include "vtable.dyno.hpp"
+
+#include <dyno.hpp>
+
+#include <cassert>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using namespace dyno::literals;
+
+
+// sample(Vehicle)
+struct Vehicle {
+  template <typename Any>
+  Vehicle(Any vehicle) : poly_{std::move(vehicle)} { }
+
+  void accelerate()
+  { poly_.virtual_("accelerate"_s)(poly_); }
+
+private:
+  dyno::poly<IVehicle, adaptive_storage<16>> poly_;
+  //                   ^^^^^^^^^^^^^^^^^^^^
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+int accelerated = 0;
+
+// 8 bytes: stored in the buffer.
+struct Bicycle {
+  int gears;
+  int speed;
+  void accelerate() { ++accelerated; ++speed; }
+};
+
+// Too large for the buffer: stored on the heap.
+struct Truck {
+  std::string make;
+  int year;
+  int speed = 0;
+  void accelerate() { ++accelerated; ++speed; }
+};
+
+// 4 KB that are never modified: shared by all the copies.
+struct Train {
+  char timetable[4096];
+  void accelerate() { ++accelerated; }
+};
+
+// Small, but costly to copy and never modified: shared as well.
+struct Shuttle {
+  std::string* route;
+  Shuttle(std::string route) : route{new std::string(std::move(route))} { }
+  Shuttle(Shuttle const& other) : route{new std::string(*other.route)} { }
+  Shuttle(Shuttle&& other) noexcept : route{other.route} { other.route = nullptr; }
+  ~Shuttle() { delete route; }
+  void accelerate() { ++accelerated; }
+};
+
+template <> struct is_immutable<Train> : std::true_type { };
+template <> struct is_immutable<Shuttle> : std::true_type { };
+
+// sample(representations)
+using Storage = adaptive_storage<16>;
+static_assert(Storage::representation_for<Bicycle>() == storage_representation::local, "");
+static_assert(Storage::representation_for<Truck>() == storage_representation::remote, "");
+static_assert(Storage::representation_for<Train>() == storage_representation::shared, "");
+static_assert(Storage::representation_for<Shuttle>() == storage_representation::shared, "");
+// end-sample
+
+// A type that can't be moved without throwing never lives in the buffer,
+// since moving it could then throw.
+struct Throwing {
+  Throwing() = default;
+  Throwing(Throwing const&) = default;
+  Throwing(Throwing&&) noexcept(false) { }
+  void accelerate() { }
+};
+static_assert(Storage::representation_for<Throwing>() == storage_representation::remote, "");
+
+int main() {
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(16);
+
+  {
+    allocation_counter counter;
+    vehicles.push_back(Bicycle{21, 0});
+    assert(counter.allocations() == 0);
+  }
+  {
+    allocation_counter counter;
+    vehicles.push_back(Truck{"Chevrolet", 2015});
+    assert(counter.allocations() == 1);
+  }
+  vehicles.push_back(Train{});
+  vehicles.push_back(Shuttle{"Airport"});
+
+  // Copying shared vehicles doesn't allocate, but copying the others does
+  // when they are on the heap.
+  {
+    allocation_counter counter;
+    std::vector<Vehicle> copies;
+    copies.reserve(4);
+    counter.reset();
+    for (auto const& vehicle : vehicles)
+      copies.push_back(vehicle);
+    assert(counter.allocations() == 1); // the truck
+    for (auto& vehicle : copies)
+      vehicle.accelerate();
+    assert(accelerated == 4);
+  }
+
+  // The shared vehicles are released along with their last copy.
+  {
+    allocation_counter counter;
+    vehicles.clear();
+    assert(counter.deallocations() == 4); // truck, train, shuttle and route
+  }
+
+  // Swapping vehicles with different representations.
+  {
+    Vehicle a = Bicycle{3, 0};
+    Vehicle b = Train{};
+    std::swap(a, b);
+    a.accelerate();
+    b.accelerate();
+    assert(accelerated == 6);
+  }
+}
@@ -0,0 +1,242 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef ADAPTIVE_STORAGE_HPP
+#define ADAPTIVE_STORAGE_HPP
+
+// A storage policy for Dyno that picks the representation of each object
+// from the traits of its type, instead of using the same one for every type
+// stored in a given `dyno::poly`:
+//
+//  - objects that fit in the buffer and can be moved without throwing are
+//    stored in the buffer, like with `dyno::local_storage`;
+//  - immutable objects that don't fit, or that are costly to copy, are
+//    shared by all the copies, like with `dyno::shared_remote_storage`;
+//  - other objects are stored on the heap, like with `dyno::remote_storage`.
+//
+// The decision is made at compile time for each type, and recorded in a
+// table of functions to copy, move and destroy objects of that type, much
+// like a vtable. The storage always holds a pointer to the object, wherever
+// it lives, so that reaching it to dispatch a call doesn't branch.
+
+#include <dyno.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// Specialize this for types whose objects are never modified after being
+// created, and can thus be shared by all their copies.
+template <typename T>
+struct is_immutable : std::false_type { };
+
+enum class storage_representation { local, remote, shared };
+
+namespace adaptive_detail {
+  // The count of references to a shared object, which is stored right
+  // before it.
+  struct shared_header {
+    std::atomic<std::size_t> references;
+  };
+
+  constexpr std::size_t header_size =
+    (sizeof(shared_header) + alignof(std::max_align_t) - 1)
+      & ~(alignof(std::max_align_t) - 1);
+
+  inline shared_header* header(void* object) {
+    return reinterpret_cast<shared_header*>(
+      static_cast<char*>(object) - header_size);
+  }
+} // end namespace adaptive_detail
+
+// sample(adaptive_storage)
+template <std::size_t BufferSize = 16>
+class adaptive_storage {
+public:
+  template <typename T>
+  static constexpr storage_representation representation_for() {
+    constexpr bool fits = sizeof(T) <= BufferSize &&
+                          alignof(T) <= alignof(std::max_align_t) &&
+                          std::is_nothrow_move_constructible<T>::value;
+    constexpr bool cheap_copy = std::is_trivially_copyable<T>::value;
+    return is_immutable<T>::value && (!fits || !cheap_copy)
+              ? storage_representation::shared
+         : fits ? storage_representation::local
+                : storage_representation::remote;
+  }
+// end-sample
+
+private:
+  // How objects of a type are copied, moved and destroyed. Moving leaves the
+  // source empty, so that it doesn't need to be destroyed afterwards.
+  struct operations {
+    void (*copy)(adaptive_storage& to, adaptive_storage const& from);
+    void (*move)(adaptive_storage& to, adaptive_storage& from);
+    void (*destroy)(adaptive_storage& self);
+  };
+
+  template <typename T, storage_representation = representation_for<T>()>
+  struct operations_for;
+
+  template <typename T>
+  struct operations_for<T, storage_representation::local> {
+    static void copy(adaptive_storage& to, adaptive_storage const& from) {
+      if (std::is_trivially_copyable<T>::value)
+        std::memcpy(to.buffer(), from.ptr_, sizeof(T));
+      else
+        new (to.buffer()) T(*static_cast<T const*>(from.ptr_));
+      to.ptr_ = to.buffer();
+    }
+    static void move(adaptive_storage& to, adaptive_storage& from) {
+      new (to.buffer()) T(std::move(*static_cast<T*>(from.ptr_)));
+      to.ptr_ = to.buffer();
+      destroy(from);
+      from.ops_ = &empty;
+    }
+    static void destroy(adaptive_storage& self)
+    { static_cast<T*>(self.ptr_)->~T(); }
+  };
+
+  template <typename T>
+  struct operations_for<T, storage_representation::remote> {
+    static void copy(adaptive_storage& to, adaptive_storage const& from)
+    { to.ptr_ = new T(*static_cast<T const*>(from.ptr_)); }
+    static void move(adaptive_storage& to, adaptive_storage& from) {
+      to.ptr_ = from.ptr_;
+      from.ops_ = &empty;
+    }
+    static void destroy(adaptive_storage& self)
+    { delete static_cast<T*>(self.ptr_); }
+  };
+
+  template <typename T>
+  struct operations_for<T, storage_representation::shared> {
+    static void copy(adaptive_storage& to, adaptive_storage const& from) {
+      adaptive_detail::header(from.ptr_)->references.fetch_add(
+        1, std::memory_order_relaxed);
+      to.ptr_ = from.ptr_;
+    }
+    static void move(adaptive_storage& to, adaptive_storage& from) {
+      to.ptr_ = from.ptr_;
+      from.ops_ = &empty;
+    }
+    static void destroy(adaptive_storage& self) {
+      adaptive_detail::shared_header* header = adaptive_detail::header(self.ptr_);
+      if (header->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        static_cast<T*>(self.ptr_)->~T();
+        header->~shared_header();
+        ::operator delete(header);
+      }
+    }
+  };
+
+  template <typename T>
+  static constexpr operations table = {
+    &operations_for<T>::copy,
+    &operations_for<T>::move,
+    &operations_for<T>::destroy
+  };
+
+  static void empty_copy(adaptive_storage&, adaptive_storage const&) { }
+  static void empty_move(adaptive_storage& to, adaptive_storage&)
+  { to.ops_ = &empty; }
+  static void empty_destroy(adaptive_storage&) { }
+
+  static constexpr operations empty = {
+    &empty_copy, &empty_move, &empty_destroy
+  };
+
+  void* buffer() { return &buffer_; }
+
+  template <storage_representation R>
+  using tag = std::integral_constant<storage_representation, R>;
+
+  template <typename T, typename Arg>
+  void* create(tag<storage_representation::local>, Arg&& arg)
+  { return new (buffer()) T(std::forward<Arg>(arg)); }
+
+  template <typename T, typename Arg>
+  void* create(tag<storage_representation::remote>, Arg&& arg)
+  { return new T(std::forward<Arg>(arg)); }
+
+  template <typename T, typename Arg>
+  void* create(tag<storage_representation::shared>, Arg&& arg) {
+    using adaptive_detail::header_size;
+    void* memory = ::operator new(header_size + sizeof(T));
+    auto* header = new (memory) adaptive_detail::shared_header{{1}};
+    try {
+      return new (static_cast<char*>(memory) + header_size)
+        T(std::forward<Arg>(arg));
+    } catch (...) {
+      header->~shared_header();
+      ::operator delete(memory);
+      throw;
+    }
+  }
+
+  adaptive_storage() : ops_{&empty}, ptr_{nullptr} { }
+
+public:
+  template <typename T, typename RawT = std::decay_t<T>>
+  explicit adaptive_storage(T&& t) : ops_{&table<RawT>} {
+    static_assert(alignof(RawT) <= alignof(std::max_align_t),
+      "over-aligned types are not supported");
+    ptr_ = create<RawT>(tag<representation_for<RawT>()>{}, std::forward<T>(t));
+  }
+
+  template <typename VTable>
+  adaptive_storage(adaptive_storage const& other, VTable const&)
+    : ops_{other.ops_}
+  { ops_->copy(*this, other); }
+
+  template <typename VTable>
+  adaptive_storage(adaptive_storage&& other, VTable const&)
+    : ops_{other.ops_}
+  { ops_->move(*this, other); }
+
+  template <typename MyVTable, typename OtherVTable>
+  void swap(MyVTable const&, adaptive_storage& other, OtherVTable const&) {
+    adaptive_storage tmp;
+    tmp.ops_ = ops_;
+    ops_->move(tmp, *this);
+    ops_ = other.ops_;
+    ops_->move(*this, other);
+    other.ops_ = tmp.ops_;
+    other.ops_->move(other, tmp);
+  }
+
+  template <typename VTable>
+  void destruct(VTable const&)
+  { ops_->destroy(*this); }
+
+  template <typename T = void>
+  T* get()
+  { return static_cast<T*>(ptr_); }
+
+  template <typename T = void>
+  T const* get() const
+  { return static_cast<T const*>(ptr_); }
+
+  static constexpr bool can_store(dyno::storage_info)
+  { return true; }
+
+private:
+  operations const* ops_;
+  void* ptr_;
+  std::aligned_storage_t<BufferSize, alignof(std::max_align_t)> buffer_;
+};
+
+template <std::size_t BufferSize>
+template <typename T>
+constexpr typename adaptive_storage<BufferSize>::operations
+adaptive_storage<BufferSize>::table;
+
+template <std::size_t BufferSize>
+constexpr typename adaptive_storage<BufferSize>::operations
+adaptive_storage<BufferSize>::empty;
+
+#endif // header guard
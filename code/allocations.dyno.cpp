@@ -0,0 +1,107 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "adaptive_storage.hpp"
+#include "allocations.hpp"
+#include "vtable.dyno.hpp"
+
+#include <dyno.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+using namespace dyno::literals;
+
+
+// A vehicle of a given size, which performs no allocations of its own.
+template <std::size_t Size>
+struct Payload {
+  char data[Size];
+  void accelerate() { }
+};
+
+// Number of allocations and deallocations expected for each operation on a
+// single object.
+struct expected {
+  std::size_t construct;
+  std::size_t copy;
+  std::size_t move;
+  std::size_t destroy;
+};
+
+template <typename Storage, std::size_t Size>
+void check(expected e) {
+  using Poly = dyno::poly<IVehicle, Storage>;
+  Payload<Size> payload{};
+
+  // Construction
+  {
+    allocation_counter counter;
+    {
+      Poly poly{payload};
+      assert(counter.allocations() == e.construct);
+      counter.reset();
+    }
+    assert(counter.deallocations() == e.destroy);
+    assert(counter.allocations() == 0);
+  }
+
+  // Copy
+  {
+    Poly poly{payload};
+    Poly const& cref = poly;
+    allocation_counter counter;
+    {
+      Poly copy{cref};
+      assert(counter.allocations() == e.copy);
+    }
+  }
+
+  // Move
+  {
+    Poly poly{payload};
+    allocation_counter counter;
+    Poly moved{std::move(poly)};
+    assert(counter.allocations() == e.move);
+    assert(counter.deallocations() == 0);
+  }
+
+  // Dispatching never allocates
+  {
+    Poly poly{payload};
+    allocation_counter counter;
+    poly.virtual_("accelerate"_s)(poly);
+    assert(counter.allocations() == 0);
+    assert(counter.deallocations() == 0);
+  }
+}
+
+int main() {
+  //                                   construct copy move destroy
+  check<dyno::local_storage<64>, 8>(   {0,        0,   0,   0});
+  check<dyno::local_storage<64>, 16>(  {0,        0,   0,   0});
+  check<dyno::local_storage<64>, 64>(  {0,        0,   0,   0});
+
+  check<dyno::sbo_storage<16>, 8>(     {0,        0,   0,   0});
+  check<dyno::sbo_storage<16>, 16>(    {0,        0,   0,   0});
+  check<dyno::sbo_storage<16>, 64>(    {1,        1,   0,   1});
+
+  check<dyno::remote_storage, 8>(      {1,        1,   0,   1});
+  check<dyno::remote_storage, 16>(     {1,        1,   0,   1});
+  check<dyno::remote_storage, 64>(     {1,        1,   0,   1});
+
+  // Copies only bump the reference count, and the object is released along
+  // with the last reference (here, the only one).
+  check<dyno::shared_remote_storage, 8>( {1,      0,   0,   1});
+  check<dyno::shared_remote_storage, 16>({1,      0,   0,   1});
+  check<dyno::shared_remote_storage, 64>({1,      0,   0,   1});
+
+  check<dyno::non_owning_storage, 8>(  {0,        0,   0,   0});
+  check<dyno::non_owning_storage, 16>( {0,        0,   0,   0});
+  check<dyno::non_owning_storage, 64>( {0,        0,   0,   0});
+
+  // Payloads are mutable, so they are either stored locally or on the heap.
+  check<adaptive_storage<16>, 8>(      {0,        0,   0,   0});
+  check<adaptive_storage<16>, 16>(     {0,        0,   0,   0});
+  check<adaptive_storage<16>, 64>(     {1,        1,   0,   1});
+}
@@ -0,0 +1,144 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef ALLOCATIONS_HPP
+#define ALLOCATIONS_HPP
+
+// Replaces the global allocation functions by versions that count how many
+// times they are called, so tests and benchmarks can check exactly how many
+// allocations an operation performs. Since this defines the replacement
+// allocation functions, it must be included in exactly one translation unit
+// of a program.
+//
+// Dyno's storage policies allocate with `std::malloc`, not `operator new`.
+// On glibc, we also interpose `malloc` and friends so that both are counted.
+// Elsewhere, only `operator new` and `operator delete` are counted.
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+
+struct allocation_counts {
+  std::size_t allocations;
+  std::size_t deallocations;
+};
+
+namespace allocations_detail {
+  allocation_counts counts = {0, 0};
+
+#if defined(__GLIBC__)
+  extern "C" void* __libc_malloc(std::size_t);
+  extern "C" void* __libc_calloc(std::size_t, std::size_t);
+  extern "C" void* __libc_realloc(void*, std::size_t);
+  extern "C" void __libc_free(void*);
+
+  inline void* raw_malloc(std::size_t n) { return __libc_malloc(n); }
+  inline void raw_free(void* p) { __libc_free(p); }
+#else
+  inline void* raw_malloc(std::size_t n) { return std::malloc(n); }
+  inline void raw_free(void* p) { std::free(p); }
+#endif
+
+  inline void* allocate(std::size_t n) {
+    void* p = raw_malloc(n == 0 ? 1 : n);
+    if (p)
+      ++counts.allocations;
+    return p;
+  }
+
+  inline void deallocate(void* p) {
+    if (p) {
+      ++counts.deallocations;
+      raw_free(p);
+    }
+  }
+} // end namespace allocations_detail
+
+// sample(allocation_counter)
+// Counts the allocations and deallocations performed since it was created.
+struct allocation_counter {
+  allocation_counter() : start_{allocations_detail::counts} { }
+
+  std::size_t allocations() const
+  { return allocations_detail::counts.allocations - start_.allocations; }
+
+  std::size_t deallocations() const
+  { return allocations_detail::counts.deallocations - start_.deallocations; }
+
+  void reset() { start_ = allocations_detail::counts; }
+
+private:
+  allocation_counts start_;
+};
+// end-sample
+
+
+#if defined(__GLIBC__)
+extern "C" {
+  void* malloc(std::size_t n) {
+    return allocations_detail::allocate(n);
+  }
+
+  void* calloc(std::size_t count, std::size_t n) {
+    void* p = allocations_detail::__libc_calloc(count, n);
+    if (p)
+      ++allocations_detail::counts.allocations;
+    return p;
+  }
+
+  void* realloc(void* p, std::size_t n) {
+    if (p == nullptr)
+      return allocations_detail::allocate(n);
+    void* result = allocations_detail::__libc_realloc(p, n);
+    if (result != p) {
+      ++allocations_detail::counts.deallocations;
+      if (result)
+        ++allocations_detail::counts.allocations;
+    }
+    return result;
+  }
+
+  void free(void* p) {
+    allocations_detail::deallocate(p);
+  }
+}
+#endif
+
+void* operator new(std::size_t n) {
+  if (void* p = allocations_detail::allocate(n))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t n) {
+  if (void* p = allocations_detail::allocate(n))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t n, std::nothrow_t const&) noexcept
+{ return allocations_detail::allocate(n); }
+
+void* operator new[](std::size_t n, std::nothrow_t const&) noexcept
+{ return allocations_detail::allocate(n); }
+
+void operator delete(void* p) noexcept
+{ allocations_detail::deallocate(p); }
+
+void operator delete[](void* p) noexcept
+{ allocations_detail::deallocate(p); }
+
+void operator delete(void* p, std::size_t) noexcept
+{ allocations_detail::deallocate(p); }
+
+void operator delete[](void* p, std::size_t) noexcept
+{ allocations_detail::deallocate(p); }
+
+void operator delete(void* p, std::nothrow_t const&) noexcept
+{ allocations_detail::deallocate(p); }
+
+void operator delete[](void* p, std::nothrow_t const&) noexcept
+{ allocations_detail::deallocate(p); }
+
+#endif // header guard
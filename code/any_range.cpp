@@ -0,0 +1,92 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "any_range.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <list>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+
+// A source that isn't backed by a container.
+struct iota_source {
+  int current;
+  int last;
+
+  std::size_t fill(int* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i != n && current != last; ++i)
+      out[i] = current++;
+    return i;
+  }
+};
+
+// sample(sum)
+// Defined in another module, which only knows about `any_range<int>`.
+int sum(any_range<int> range) {
+  int total = 0;
+  range.for_each_chunk([&](int const* chunk, std::size_t n) {
+    for (std::size_t i = 0; i != n; ++i)
+      total += chunk[i];
+  });
+  return total;
+}
+// end-sample
+
+int main() {
+  std::vector<int> vector(1000);
+  std::iota(vector.begin(), vector.end(), 0);
+  std::list<int> list(vector.begin(), vector.end());
+
+// sample(main)
+  assert(sum({vector.begin(), vector.end()}) == 499500);
+  assert(sum({list.begin(), list.end()}) == 499500);
+  assert(sum(any_range<int>{iota_source{0, 1000}}) == 499500);
+// end-sample
+
+  // Chunks are as large as possible, and the last one is partial.
+  {
+    any_range<int, 64> range{vector.begin(), vector.end()};
+    std::vector<std::size_t> sizes;
+    range.for_each_chunk([&](int const*, std::size_t n) { sizes.push_back(n); });
+    assert(sizes.size() == 16);
+    assert(sizes.front() == 64);
+    assert(sizes.back() == 1000 % 64);
+  }
+
+  // Elements can be pulled in chunks of any size, and the range picks up
+  // where the last chunk ended.
+  {
+    any_range<int> range{iota_source{0, 10}};
+    int buffer[4];
+    assert(range.next(buffer, 4) == 4);
+    assert(buffer[0] == 0 && buffer[3] == 3);
+    assert(range.next(buffer, 1) == 1);
+    assert(buffer[0] == 4);
+
+    std::vector<int> rest;
+    range.for_each([&](int i) { rest.push_back(i); });
+    assert((rest == std::vector<int>{5, 6, 7, 8, 9}));
+    assert(range.next(buffer, 4) == 0);
+  }
+
+  // Ranges can be moved around.
+  {
+    any_range<int> range{list.begin(), list.end()};
+    int prefix[10];
+    assert(range.next(prefix, 10) == 10 && prefix[9] == 9);
+    any_range<int> moved{std::move(range)};
+    int next;
+    assert(moved.next(&next, 1) == 1 && next == 10);
+    assert(sum(std::move(moved)) == 499500 - 55);
+  }
+
+  // Empty ranges.
+  {
+    std::vector<int> empty;
+    assert(sum({empty.begin(), empty.end()}) == 0);
+  }
+}
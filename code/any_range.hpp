@@ -0,0 +1,96 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef ANY_RANGE_HPP
+#define ANY_RANGE_HPP
+
+// A type-erased sequence of `T`s. Instead of erasing an iterator, which costs
+// an indirect call to dereference, increment and compare it for every element,
+// the only erased operation is "copy the next chunk of up to `n` elements into
+// this buffer". The cost of dispatching is paid once per chunk, and consumers
+// get to loop over plain arrays.
+
+#include <dyno.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+using namespace dyno::literals;
+
+
+// A source of elements is anything with a `fill(T* out, std::size_t n)` method
+// writing up to `n` elements to `out` and returning how many it wrote, 0
+// meaning that the source is exhausted.
+template <typename T>
+struct Source : decltype(dyno::requires(
+  dyno::MoveConstructible{},
+  dyno::Destructible{},
+  "fill"_s = dyno::function<std::size_t (dyno::T&, T*, std::size_t)>
+)) { };
+
+template <typename T, typename S>
+auto const dyno::default_concept_map<Source<T>, S> = dyno::make_concept_map(
+  "fill"_s = [](S& source, T* out, std::size_t n) -> std::size_t {
+    return source.fill(out, n);
+  }
+);
+
+// The source of an iterator range.
+template <typename Iterator>
+struct iterator_source {
+  Iterator first;
+  Iterator last;
+
+  template <typename T>
+  std::size_t fill(T* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i != n && first != last; ++i, ++first)
+      out[i] = *first;
+    return i;
+  }
+};
+
+// sample(any_range)
+template <typename T, std::size_t ChunkSize = 64>
+struct any_range {
+  template <typename Iterator>
+  any_range(Iterator first, Iterator last)
+    : poly_{iterator_source<Iterator>{first, last}}
+  { }
+
+  template <typename AnySource, typename = std::enable_if_t<
+    !std::is_same<std::decay_t<AnySource>, any_range>::value
+  >>
+  explicit any_range(AnySource&& source)
+    : poly_{std::forward<AnySource>(source)}
+  { }
+
+  // Copies the next elements (at most `n`) to `out`, and returns how many
+  // were copied. Returns 0 once the range is exhausted.
+  std::size_t next(T* out, std::size_t n)
+  { return poly_.virtual_("fill"_s)(poly_, out, n); }
+
+  // Calls `f` with each remaining chunk of elements, as a pointer and a size.
+  template <typename F>
+  void for_each_chunk(F f) {
+    T chunk[ChunkSize];
+    while (std::size_t n = next(chunk, ChunkSize))
+      f(static_cast<T const*>(chunk), n);
+  }
+
+  // Calls `f` with each remaining element.
+  template <typename F>
+  void for_each(F f) {
+    for_each_chunk([&](T const* chunk, std::size_t n) {
+      for (std::size_t i = 0; i != n; ++i)
+        f(chunk[i]);
+    });
+  }
+
+private:
+  dyno::poly<Source<T>, dyno::sbo_storage<32>> poly_;
+};
+// end-sample
+
+#endif // header guard
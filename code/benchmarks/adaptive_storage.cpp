@@ -0,0 +1,80 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// A collection mixing vehicles of 8 bytes, 64 bytes and 4 KB, the latter
+// being immutable. Each storage policy is measured when copying the whole
+// collection and when accelerating every vehicle.
+
+#include "adaptive_storage.hpp"
+#include "allocations.hpp"
+#include "vehicles.hpp"
+
+#include <benchmark/benchmark.h>
+#include <dyno.hpp>
+
+#include <cstddef>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+
+template <std::size_t Size>
+struct Payload {
+  char data[Size];
+  void accelerate() { benchmark::DoNotOptimize(data); }
+};
+
+template <>
+struct is_immutable<Payload<4096>> : std::true_type { };
+
+template <typename Vehicle>
+std::vector<Vehicle> make_vehicles(std::size_t n) {
+  std::mt19937 rng{12345};
+  std::uniform_int_distribution<int> kind{0, 9};
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    int const k = kind(rng);
+    if (k < 6)      vehicles.push_back(Payload<8>{});    // 60%
+    else if (k < 9) vehicles.push_back(Payload<64>{});   // 30%
+    else            vehicles.push_back(Payload<4096>{}); // 10%
+  }
+  return vehicles;
+}
+
+template <typename Storage>
+void copy(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  std::vector<Vehicle<Storage>> const vehicles = make_vehicles<Vehicle<Storage>>(n);
+  allocation_counter counter;
+  while (state.KeepRunning()) {
+    std::vector<Vehicle<Storage>> copy(vehicles);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.counters["allocs"] = benchmark::Counter(
+    counter.allocations(), benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Storage>
+void accelerate(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  std::vector<Vehicle<Storage>> vehicles = make_vehicles<Vehicle<Storage>>(n);
+  while (state.KeepRunning()) {
+    for (auto& vehicle : vehicles)
+      vehicle.accelerate();
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define BENCHMARK_STORAGE(...)                                                \
+  BENCHMARK_TEMPLATE(copy, __VA_ARGS__)->Arg(1 << 12);                        \
+  BENCHMARK_TEMPLATE(accelerate, __VA_ARGS__)->Arg(1 << 12)
+
+BENCHMARK_STORAGE(adaptive_storage<16>);
+BENCHMARK_STORAGE(dyno::sbo_storage<16>);
+BENCHMARK_STORAGE(dyno::remote_storage);
+BENCHMARK_STORAGE(dyno::shared_remote_storage);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,63 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "allocations.hpp"
+#include "vtable.dyno.hpp"
+
+#include <benchmark/benchmark.h>
+#include <dyno.hpp>
+
+#include <cstddef>
+
+
+template <std::size_t Size>
+struct Payload {
+  char data[Size];
+  void accelerate() { benchmark::DoNotOptimize(data); }
+};
+
+// Reports the number of allocations per iteration next to the timings.
+void report(benchmark::State& state, allocation_counter const& counter) {
+  state.counters["allocs"] = benchmark::Counter(
+    counter.allocations(), benchmark::Counter::kAvgIterations);
+  state.counters["deallocs"] = benchmark::Counter(
+    counter.deallocations(), benchmark::Counter::kAvgIterations);
+}
+
+// Constructs and destroys an object.
+template <typename Storage, std::size_t Size>
+void construct(benchmark::State& state) {
+  Payload<Size> payload{};
+  allocation_counter counter;
+  while (state.KeepRunning()) {
+    dyno::poly<IVehicle, Storage> poly{payload};
+    benchmark::DoNotOptimize(poly);
+  }
+  report(state, counter);
+}
+
+// Copies and destroys an object.
+template <typename Storage, std::size_t Size>
+void copy(benchmark::State& state) {
+  Payload<Size> payload{};
+  dyno::poly<IVehicle, Storage> const poly{payload};
+  allocation_counter counter;
+  while (state.KeepRunning()) {
+    dyno::poly<IVehicle, Storage> copy{poly};
+    benchmark::DoNotOptimize(copy);
+  }
+  report(state, counter);
+}
+
+#define BENCHMARK_STORAGE(Storage)            \
+  BENCHMARK_TEMPLATE(construct, Storage, 8);  \
+  BENCHMARK_TEMPLATE(construct, Storage, 64); \
+  BENCHMARK_TEMPLATE(copy, Storage, 8);       \
+  BENCHMARK_TEMPLATE(copy, Storage, 64)
+
+BENCHMARK_STORAGE(dyno::local_storage<64>);
+BENCHMARK_STORAGE(dyno::sbo_storage<16>);
+BENCHMARK_STORAGE(dyno::remote_storage);
+BENCHMARK_STORAGE(dyno::shared_remote_storage);
+
+BENCHMARK_MAIN();
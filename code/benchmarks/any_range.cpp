@@ -0,0 +1,107 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Sums a sequence of integers passed through a type-erased interface, either
+// as an iterator erased element by element (three indirect calls per element
+// to check for the end, dereference and increment) or as an `any_range` read
+// in chunks of increasing size. `direct` is the same loop without erasure.
+
+#include "any_range.hpp"
+
+#include <benchmark/benchmark.h>
+#include <dyno.hpp>
+
+#include <cstddef>
+#include <numeric>
+#include <vector>
+using namespace dyno::literals;
+
+
+template <typename T>
+struct Cursor : decltype(dyno::requires(
+  dyno::MoveConstructible{},
+  dyno::Destructible{},
+  "done"_s = dyno::function<bool (dyno::T const&)>,
+  "dereference"_s = dyno::function<T (dyno::T const&)>,
+  "increment"_s = dyno::function<void (dyno::T&)>
+)) { };
+
+template <typename T, typename Iterator>
+auto const dyno::default_concept_map<Cursor<T>, iterator_source<Iterator>> =
+  dyno::make_concept_map(
+    "done"_s = [](iterator_source<Iterator> const& s) {
+      return s.first == s.last;
+    },
+    "dereference"_s = [](iterator_source<Iterator> const& s) -> T {
+      return *s.first;
+    },
+    "increment"_s = [](iterator_source<Iterator>& s) { ++s.first; }
+  );
+
+// What passing an iterator across an interface usually looks like.
+template <typename T>
+struct any_iterator {
+  template <typename Iterator>
+  any_iterator(Iterator first, Iterator last)
+    : poly_{iterator_source<Iterator>{first, last}}
+  { }
+
+  bool done() const { return poly_.virtual_("done"_s)(poly_); }
+  T operator*() const { return poly_.virtual_("dereference"_s)(poly_); }
+  void operator++() { poly_.virtual_("increment"_s)(poly_); }
+
+private:
+  dyno::poly<Cursor<T>, dyno::sbo_storage<32>> poly_;
+};
+
+std::vector<int> make_ints(std::size_t size) {
+  std::vector<int> ints(size);
+  std::iota(ints.begin(), ints.end(), 0);
+  return ints;
+}
+
+void direct(benchmark::State& state) {
+  std::vector<int> const ints = make_ints(state.range(0));
+  while (state.KeepRunning()) {
+    int total = 0;
+    for (int i : ints)
+      total += i;
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * ints.size());
+}
+
+void per_element(benchmark::State& state) {
+  std::vector<int> const ints = make_ints(state.range(0));
+  while (state.KeepRunning()) {
+    any_iterator<int> it{ints.begin(), ints.end()};
+    int total = 0;
+    for (; !it.done(); ++it)
+      total += *it;
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * ints.size());
+}
+
+void chunked(benchmark::State& state) {
+  std::vector<int> const ints = make_ints(state.range(0));
+  std::size_t const chunk_size = state.range(1);
+  std::vector<int> chunk(chunk_size);
+  while (state.KeepRunning()) {
+    any_range<int> range{ints.begin(), ints.end()};
+    int total = 0;
+    while (std::size_t n = range.next(chunk.data(), chunk_size))
+      for (std::size_t i = 0; i != n; ++i)
+        total += chunk[i];
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * ints.size());
+}
+
+BENCHMARK(direct)->ArgName("size")->RangeMultiplier(64)->Range(1 << 10, 1 << 22);
+BENCHMARK(per_element)->ArgName("size")->RangeMultiplier(64)->Range(1 << 10, 1 << 22);
+BENCHMARK(chunked)->ArgNames({"size", "chunk"})
+  ->RangeMultiplier(64)->Ranges({{1 << 10, 1 << 22}, {1, 1024}})
+  ->Args({1 << 16, 4})->Args({1 << 16, 16})->Args({1 << 16, 256});
+
+BENCHMARK_MAIN();
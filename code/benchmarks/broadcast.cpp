@@ -0,0 +1,75 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Broadcasts an event to thousands of subscribers of a few different types,
+// which are stored as a `std::vector` of `function`s (one indirect call per
+// subscriber) or in a `callback_list` (one indirect call per type).
+
+#include "callback_list.hpp"
+#include "function.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+
+struct Event { int value; };
+
+template <int Kind>
+struct Subscriber {
+  int* total;
+  void operator()(Event const& e) const { *total += e.value * Kind; }
+};
+
+// Subscribes callbacks of `types` different types, in a random order.
+template <typename Subscribe>
+void subscribe_all(std::size_t n, int types, int* total, Subscribe subscribe) {
+  std::mt19937 rng{12345};
+  std::uniform_int_distribution<int> kind{0, types - 1};
+  for (std::size_t i = 0; i != n; ++i) {
+    switch (kind(rng)) {
+      case 0: subscribe(Subscriber<1>{total}); break;
+      case 1: subscribe(Subscriber<2>{total}); break;
+      case 2: subscribe(Subscriber<3>{total}); break;
+      default: subscribe(Subscriber<4>{total}); break;
+    }
+  }
+}
+
+void vector_of_functions(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  int total = 0;
+  std::vector<function<void(Event const&)>> subscribers;
+  subscribe_all(n, state.range(1), &total, [&](auto f) {
+    subscribers.push_back(f);
+  });
+  while (state.KeepRunning()) {
+    for (auto const& subscriber : subscribers)
+      subscriber(Event{1});
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+void grouped_by_type(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  int total = 0;
+  callback_list<void(Event const&)> subscribers;
+  subscribe_all(n, state.range(1), &total, [&](auto f) {
+    subscribers.subscribe(f);
+  });
+  while (state.KeepRunning()) {
+    subscribers(Event{1});
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(vector_of_functions)->ArgNames({"size", "types"})
+  ->Args({1 << 10, 1})->Args({1 << 10, 4})->Args({1 << 14, 1})->Args({1 << 14, 4});
+BENCHMARK(grouped_by_type)->ArgNames({"size", "types"})
+  ->Args({1 << 10, 1})->Args({1 << 10, 4})->Args({1 << 14, 1})->Args({1 << 14, 4});
+
+BENCHMARK_MAIN();
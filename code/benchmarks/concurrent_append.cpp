@@ -0,0 +1,61 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Appends vehicles to a collection shared by 1 to 64 threads, with a
+// `concurrent_poly_vector` and with a `std::vector` protected by a mutex.
+
+#include "concurrent_poly_vector.hpp"
+#include "vehicles.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+template <typename T>
+class locked_vector {
+public:
+  template <typename Any>
+  void push_back(Any&& value) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    vector_.push_back(std::forward<Any>(value));
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<T> vector_;
+};
+
+// Created by the first thread before the others start, and destroyed by
+// the first thread once they are all done.
+template <typename Collection>
+std::unique_ptr<Collection> shared_collection;
+
+template <typename Collection>
+void append(benchmark::State& state) {
+  if (state.thread_index() == 0)
+    shared_collection<Collection> = std::make_unique<Collection>();
+
+  while (state.KeepRunning())
+    shared_collection<Collection>->push_back(Car{"Audi", 2017});
+
+  if (state.thread_index() == 0)
+    shared_collection<Collection>.reset();
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The number of iterations is fixed, since every iteration adds a vehicle
+// that is only freed at the end.
+#define BENCHMARK_COLLECTION(...)                                             \
+  BENCHMARK_TEMPLATE(append, __VA_ARGS__)                                     \
+    ->ThreadRange(1, 64)->Iterations(1 << 16)->UseRealTime()
+
+BENCHMARK_COLLECTION(locked_vector<remote_storage_vehicle>);
+BENCHMARK_COLLECTION(concurrent_poly_vector<remote_storage_vehicle>);
+BENCHMARK_COLLECTION(locked_vector<local_storage_vehicle>);
+BENCHMARK_COLLECTION(concurrent_poly_vector<local_storage_vehicle>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,51 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "perf_counters.hpp"
+#include "vehicles.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+
+// Accelerates every vehicle in a collection, for each Vehicle strategy. The
+// hardware counters are reported per call to `accelerate()`.
+template <typename Vehicle>
+void accelerate(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    switch (i % 3) {
+      case 0: vehicles.push_back(Car{"Audi", 2017}); break;
+      case 1: vehicles.push_back(Truck{"Chevrolet", 2015}); break;
+      case 2: vehicles.push_back(Plane{"Boeing", "747"}); break;
+    }
+  }
+
+  perf_counters counters;
+  counters.start();
+  while (state.KeepRunning()) {
+    for (auto& vehicle : vehicles)
+      vehicle.accelerate();
+    benchmark::ClobberMemory();
+  }
+  counters.stop();
+  counters.report(state, n);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define BENCHMARK_VEHICLE(Vehicle) \
+  BENCHMARK_TEMPLATE(accelerate, Vehicle)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)
+
+BENCHMARK_VEHICLE(inheritance_vehicle);
+BENCHMARK_VEHICLE(remote_storage_vehicle);
+BENCHMARK_VEHICLE(sbo_storage_vehicle);
+BENCHMARK_VEHICLE(local_storage_vehicle);
+BENCHMARK_VEHICLE(shared_remote_storage_vehicle);
+BENCHMARK_VEHICLE(local_vtable_vehicle);
+BENCHMARK_VEHICLE(joined_vtable_vehicle);
+
+BENCHMARK_MAIN();
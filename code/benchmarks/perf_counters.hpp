@@ -0,0 +1,119 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef BENCHMARKS_PERF_COUNTERS_HPP
+#define BENCHMARKS_PERF_COUNTERS_HPP
+
+// Hardware performance counters read through `perf_event_open`, so we can
+// tell why a technique is faster than another, not only that it is.
+//
+// Counters that can't be opened (not on Linux, no PMU in a VM, restrictive
+// `perf_event_paranoid`, etc.) are simply not reported.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+
+struct perf_counters {
+  perf_counters() {
+#if defined(__linux__)
+    auto cache = [](std::uint64_t cache, std::uint64_t op) {
+      return cache | (op << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open("branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    open("L1d-misses", PERF_TYPE_HW_CACHE,
+         cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ));
+    open("LLC-misses", PERF_TYPE_HW_CACHE,
+         cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ));
+    open("iTLB-misses", PERF_TYPE_HW_CACHE,
+         cache(PERF_COUNT_HW_CACHE_ITLB, PERF_COUNT_HW_CACHE_OP_READ));
+#endif
+  }
+
+  perf_counters(perf_counters const&) = delete;
+  perf_counters& operator=(perf_counters const&) = delete;
+
+  ~perf_counters() {
+#if defined(__linux__)
+    for (auto const& counter : counters_)
+      ::close(counter.fd);
+#endif
+  }
+
+  bool available() const { return !counters_.empty(); }
+
+  void start() {
+#if defined(__linux__)
+    for (auto const& counter : counters_) {
+      ::ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+      ::ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  void stop() {
+#if defined(__linux__)
+    for (auto const& counter : counters_)
+      ::ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+  }
+
+  // Adds the value of each counter, divided by `per` operations in each
+  // iteration, to the benchmark's reported counters.
+  void report(benchmark::State& state, double per = 1) const {
+#if defined(__linux__)
+    for (auto const& counter : counters_) {
+      struct { std::uint64_t value, enabled, running; } data;
+      if (::read(counter.fd, &data, sizeof(data)) != sizeof(data) ||
+          data.running == 0)
+        continue;
+      // Scale the value when the counters had to be multiplexed.
+      double value = static_cast<double>(data.value) *
+                     (static_cast<double>(data.enabled) / data.running);
+      state.counters[counter.name] = benchmark::Counter(
+        value / per, benchmark::Counter::kAvgIterations);
+    }
+#else
+    (void)state; (void)per;
+#endif
+  }
+
+private:
+#if defined(__linux__)
+  void open(char const* name, std::uint32_t type, std::uint64_t config) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr,
+                                        0 /* this thread */, -1 /* any cpu */,
+                                        -1 /* no group */, 0 /* flags */));
+    if (fd >= 0)
+      counters_.push_back({name, fd});
+  }
+
+  struct counter { std::string name; int fd; };
+  std::vector<counter> counters_;
+#else
+  std::vector<int> counters_;
+#endif
+};
+
+#endif // header guard
@@ -0,0 +1,74 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Runs values through a pipeline of stages, where each stage was erased
+// into its own `function` (one indirect call per stage), where the stages
+// were composed with `then` and erased once, and where nothing is erased.
+
+#include "function.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+
+struct Scale { int factor; int operator()(int x) const { return x * factor; } };
+struct Offset { int offset; int operator()(int x) const { return x + offset; } };
+struct Clamp { int max; int operator()(int x) const { return x < max ? x : max; } };
+struct Square { int operator()(int x) const { return x * x; } };
+
+auto make_pipeline() {
+  return then(Scale{3}, Offset{7}).then(Clamp{1000}).then(Square{})
+                                  .then(Offset{-1}).then(Scale{5})
+                                  .then(Clamp{1 << 20}).then(Offset{2});
+}
+
+std::vector<int> make_inputs() {
+  std::vector<int> inputs(1 << 12);
+  for (std::size_t i = 0; i != inputs.size(); ++i)
+    inputs[i] = static_cast<int>(i);
+  return inputs;
+}
+
+void erased_stages(benchmark::State& state) {
+  std::vector<int> const inputs = make_inputs();
+  std::vector<function<int(int)>> stages = {
+    Scale{3}, Offset{7}, Clamp{1000}, Square{},
+    Offset{-1}, Scale{5}, Clamp{1 << 20}, Offset{2}
+  };
+  while (state.KeepRunning()) {
+    for (int x : inputs) {
+      for (auto const& stage : stages)
+        x = stage(x);
+      benchmark::DoNotOptimize(x);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+
+void fused_stages(benchmark::State& state) {
+  std::vector<int> const inputs = make_inputs();
+  function<int(int)> const pipeline = make_pipeline();
+  while (state.KeepRunning()) {
+    for (int x : inputs)
+      benchmark::DoNotOptimize(pipeline(x));
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+
+void direct(benchmark::State& state) {
+  std::vector<int> const inputs = make_inputs();
+  auto const pipeline = make_pipeline();
+  while (state.KeepRunning()) {
+    for (int x : inputs)
+      benchmark::DoNotOptimize(pipeline(x));
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+
+BENCHMARK(erased_stages);
+BENCHMARK(fused_stages);
+BENCHMARK(direct);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Measures `prefetching_for_each` on collections of heap-allocated vehicles
+// that are much larger than the caches, for several prefetch distances and
+// with a `prefetch_tuner`. The vehicles are shuffled after being allocated,
+// so that the hardware prefetcher can't guess where the next object is.
+
+#include "perf_counters.hpp"
+#include "prefetch.hpp"
+#include "vtable.hpp"
+#include "workload.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+class Vehicle {
+  vtable const* vptr_;
+  void* ptr_;
+
+public:
+  template <typename Any>
+  Vehicle(Any vehicle)
+    : vptr_{&vtable_for<Any>}
+    , ptr_{new Any(std::move(vehicle))}
+  { }
+
+  Vehicle(Vehicle&& other) noexcept
+    : vptr_{other.vptr_}, ptr_{other.ptr_}
+  { other.ptr_ = nullptr; }
+
+  Vehicle& operator=(Vehicle&& other) noexcept {
+    std::swap(vptr_, other.vptr_);
+    std::swap(ptr_, other.ptr_);
+    return *this;
+  }
+
+  void accelerate()
+  { vptr_->accelerate(ptr_); }
+
+  void prefetch() const
+  { ::prefetch(vptr_); ::prefetch(ptr_); }
+
+  ~Vehicle()
+  { if (ptr_ != nullptr) vptr_->delete_(ptr_); }
+};
+
+std::vector<Vehicle> make_fleet(std::size_t size) {
+  workload w;
+  w.size = size;
+  w.types = 16;
+  w.zipf = 0;
+  w.order = ordering::shuffled;
+  std::vector<Vehicle> vehicles = make_vehicles<Vehicle>(w);
+  std::mt19937 rng{w.seed};
+  std::shuffle(vehicles.begin(), vehicles.end(), rng);
+  return vehicles;
+}
+
+void accelerate(benchmark::State& state) {
+  std::size_t const size = state.range(0);
+  std::size_t const distance = state.range(1);
+  std::vector<Vehicle> vehicles = make_fleet(size);
+
+  perf_counters counters;
+  counters.start();
+  while (state.KeepRunning()) {
+    prefetching_for_each(vehicles.begin(), vehicles.end(),
+                         [](Vehicle& v) { v.accelerate(); }, distance);
+    benchmark::ClobberMemory();
+  }
+  counters.stop();
+  counters.report(state, size);
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+void accelerate_tuned(benchmark::State& state) {
+  std::size_t const size = state.range(0);
+  std::vector<Vehicle> vehicles = make_fleet(size);
+
+  prefetch_tuner tuner;
+  while (state.KeepRunning()) {
+    tuner.for_each(vehicles.begin(), vehicles.end(),
+                   [](Vehicle& v) { v.accelerate(); });
+    benchmark::ClobberMemory();
+  }
+  state.counters["distance"] = tuner.distance();
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+void sweep(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"size", "distance"});
+  for (long size : {1 << 12, 1 << 16, 1 << 20, 1 << 22})
+    for (long distance : {0, 1, 2, 4, 8, 16, 32, 64})
+      b->Args({size, distance});
+}
+
+BENCHMARK(accelerate)->Apply(sweep);
+BENCHMARK(accelerate_tuned)->ArgName("size")
+  ->RangeMultiplier(16)->Range(1 << 12, 1 << 22);
+
+BENCHMARK_MAIN();
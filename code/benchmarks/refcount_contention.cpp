@@ -0,0 +1,66 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Compares the cost of copying a `shared_function` from several threads at
+// once when the reference count is a single atomic (`dyno::shared_remote_storage`)
+// and when it is biased towards the thread that created the object.
+
+#include "biased_shared_storage.hpp"
+#include "function.hpp"
+
+#include <benchmark/benchmark.h>
+#include <dyno.hpp>
+
+#include <memory>
+
+
+struct Add {
+  int n;
+  int operator()(int i) const { return i + n; }
+};
+
+template <typename Storage>
+using Function = basic_function<int(int), Storage>;
+
+// Created by the first thread, which runs on the main thread, before the
+// others start, and destroyed by it once they are all done. It must not
+// outlive the benchmark, since the biased storage releases it through a
+// `thread_local` of the main thread. The other threads contend on the same
+// reference count.
+template <typename Storage>
+std::unique_ptr<Function<Storage> const> shared_instance;
+
+// Copies and destroys a function shared by all the threads.
+template <typename Storage>
+void copy_shared(benchmark::State& state) {
+  if (state.thread_index() == 0)
+    shared_instance<Storage> = std::make_unique<Function<Storage>>(Add{1});
+
+  while (state.KeepRunning()) {
+    Function<Storage> copy{*shared_instance<Storage>};
+    benchmark::DoNotOptimize(copy);
+  }
+
+  if (state.thread_index() == 0)
+    shared_instance<Storage>.reset();
+}
+
+// Copies and destroys a function created by the calling thread, which is
+// the common case that biasing optimizes for.
+template <typename Storage>
+void copy_owned(benchmark::State& state) {
+  Function<Storage> const f{Add{1}};
+  while (state.KeepRunning()) {
+    Function<Storage> copy{f};
+    benchmark::DoNotOptimize(copy);
+  }
+}
+
+#define BENCHMARK_STORAGE(Storage)                                            \
+  BENCHMARK_TEMPLATE(copy_shared, Storage)->ThreadRange(1, 32)->UseRealTime();\
+  BENCHMARK_TEMPLATE(copy_owned, Storage)->ThreadRange(1, 32)->UseRealTime()
+
+BENCHMARK_STORAGE(dyno::shared_remote_storage);
+BENCHMARK_STORAGE(biased_shared_remote_storage);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Replays a dispatch trace recorded by a program built with `-DTRACE_DISPATCH`
+// (see `dispatch_trace.hpp`) against every Vehicle strategy, so they can be
+// compared on a real call pattern.
+//
+//  usage: benchmark.replay [benchmark options] TRACE_FILE
+//
+// Every distinct (address, type) in the trace becomes an object, whose type
+// is mapped to one of the `Kind<I>` types of `workload.hpp`, and the objects
+// are then called in the order recorded in the trace.
+
+#include "dispatch_trace.hpp"
+#include "perf_counters.hpp"
+#include "vehicles.hpp"
+#include "workload.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+struct replay_plan {
+  std::vector<std::size_t> types;   // the type of each object
+  std::vector<std::uint32_t> calls; // the object called at each step
+};
+
+replay_plan make_plan(std::vector<dispatch_record> const& records) {
+  replay_plan plan;
+  std::unordered_map<std::uint32_t, std::size_t> types;
+  std::map<std::pair<std::uint64_t, std::uint32_t>, std::uint32_t> objects;
+  plan.calls.reserve(records.size());
+
+  for (dispatch_record const& record : records) {
+    // Our Vehicles only have `accelerate()`.
+    if (record.method != static_cast<std::uint32_t>(dispatch_method::accelerate))
+      continue;
+
+    // Number types in order of appearance, so the most common ones in a
+    // short trace get distinct `Kind`s.
+    auto type = types.emplace(record.type, types.size() % max_types).first;
+
+    // The same address may be reused by an object of another type after
+    // the first one is destroyed.
+    auto object = objects.emplace(std::make_pair(record.address, record.type),
+                                  plan.types.size());
+    if (object.second)
+      plan.types.push_back(type->second);
+    plan.calls.push_back(object.first->second);
+  }
+  return plan;
+}
+
+template <typename Vehicle>
+void replay(benchmark::State& state, replay_plan const& plan) {
+  std::vector<Vehicle> vehicles = make_vehicles<Vehicle>(plan.types);
+
+  perf_counters counters;
+  counters.start();
+  while (state.KeepRunning()) {
+    for (std::uint32_t object : plan.calls)
+      vehicles[object].accelerate();
+    benchmark::ClobberMemory();
+  }
+  counters.stop();
+  counters.report(state, plan.calls.size());
+  state.SetItemsProcessed(state.iterations() * plan.calls.size());
+}
+
+#define REGISTER_VEHICLE(Vehicle)                                           \
+  benchmark::RegisterBenchmark("replay<" #Vehicle ">",                      \
+    [&plan](benchmark::State& state) { replay<Vehicle>(state, plan); })
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " [benchmark options] TRACE_FILE\n";
+    return 1;
+  }
+
+  replay_plan plan;
+  try {
+    plan = make_plan(dispatch_trace::load(argv[1]));
+  } catch (std::exception const& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  std::cerr << "replaying " << plan.calls.size() << " calls on "
+            << plan.types.size() << " objects\n";
+
+  REGISTER_VEHICLE(inheritance_vehicle);
+  REGISTER_VEHICLE(remote_storage_vehicle);
+  REGISTER_VEHICLE(sbo_storage_vehicle);
+  REGISTER_VEHICLE(local_storage_vehicle);
+  REGISTER_VEHICLE(shared_remote_storage_vehicle);
+  REGISTER_VEHICLE(local_vtable_vehicle);
+  REGISTER_VEHICLE(joined_vtable_vehicle);
+
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,47 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Fills a collection with a few small vehicles, copies it and destroys both,
+// which is the life of an object owning a handful of Vehicles. The vehicles
+// are stored in a `std::vector` or in a `small_poly_vector` holding up to 8
+// of them inline.
+
+#include "allocations.hpp"
+#include "small_poly_vector.hpp"
+#include "vtable.dyno.hpp"
+
+#include <benchmark/benchmark.h>
+#include <dyno.hpp>
+
+#include <cstddef>
+#include <vector>
+
+
+struct Payload {
+  char data[16];
+  void accelerate() { benchmark::DoNotOptimize(data); }
+};
+
+using Storage = dyno::sbo_storage<16>;
+
+template <typename Collection>
+void fill_and_copy(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  allocation_counter counter;
+  while (state.KeepRunning()) {
+    Collection vehicles;
+    for (std::size_t i = 0; i != n; ++i)
+      vehicles.push_back(Payload{});
+    Collection copy(vehicles);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.counters["allocs"] = benchmark::Counter(
+    counter.allocations(), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_TEMPLATE(fill_and_copy, std::vector<dyno::poly<IVehicle, Storage>>)
+  ->ArgName("size")->DenseRange(1, 8)->Arg(16);
+BENCHMARK_TEMPLATE(fill_and_copy, small_poly_vector<IVehicle, 8, Storage>)
+  ->ArgName("size")->DenseRange(1, 8)->Arg(16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "perf_counters.hpp"
+#include "vehicles.hpp"
+#include "workload.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+
+// Accelerates every vehicle in a collection whose type mix is described by
+// the arguments: the number of distinct types, the ordering (0 = sorted,
+// 1 = clustered, 2 = shuffled) and the Zipf exponent times 100.
+template <typename Vehicle>
+void accelerate(benchmark::State& state) {
+  workload w;
+  w.size = 1 << 16;
+  w.types = state.range(0);
+  w.order = static_cast<ordering>(state.range(1));
+  w.zipf = state.range(2) / 100.0;
+  std::vector<Vehicle> vehicles = make_vehicles<Vehicle>(w);
+
+  perf_counters counters;
+  counters.start();
+  while (state.KeepRunning()) {
+    for (auto& vehicle : vehicles)
+      vehicle.accelerate();
+    benchmark::ClobberMemory();
+  }
+  counters.stop();
+  counters.report(state, w.size);
+  state.SetItemsProcessed(state.iterations() * w.size);
+}
+
+void sweep(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"types", "order", "zipf"});
+  for (long types : {1, 2, 4, 16, 64, 256})
+    for (long order : {0, 1, 2})
+      for (long zipf : {0, 100})
+        b->Args({types, order, zipf});
+}
+
+#define BENCHMARK_VEHICLE(Vehicle) \
+  BENCHMARK_TEMPLATE(accelerate, Vehicle)->Apply(sweep)
+
+BENCHMARK_VEHICLE(inheritance_vehicle);
+BENCHMARK_VEHICLE(remote_storage_vehicle);
+BENCHMARK_VEHICLE(sbo_storage_vehicle);
+BENCHMARK_VEHICLE(local_storage_vehicle);
+BENCHMARK_VEHICLE(shared_remote_storage_vehicle);
+BENCHMARK_VEHICLE(local_vtable_vehicle);
+BENCHMARK_VEHICLE(joined_vtable_vehicle);
+
+BENCHMARK_MAIN();
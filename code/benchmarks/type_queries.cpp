@@ -0,0 +1,140 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// Accelerates a collection of vehicles in which cars are the most common,
+// either always through the vtable, or by giving cars a fast path with no
+// indirect call. The fast path is selected by comparing vtable pointers for
+// hand-rolled vehicles, and with `dynamic_cast` or `typeid` for vehicles
+// using inheritance.
+
+#include "vehicles.hpp"
+#include "vtable.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+
+// A hand-rolled vehicle that can be asked for its type.
+class queryable_vehicle {
+  vtable const* vptr_;
+  void* ptr_;
+
+public:
+  template <typename Any>
+  queryable_vehicle(Any vehicle)
+    : vptr_{&vtable_for<Any>}
+    , ptr_{new Any(std::move(vehicle))}
+  { }
+
+  queryable_vehicle(queryable_vehicle&& other) noexcept
+    : vptr_{other.vptr_}, ptr_{other.ptr_}
+  { other.ptr_ = nullptr; }
+
+  void accelerate()
+  { vptr_->accelerate(ptr_); }
+
+  template <typename T>
+  bool holds() const
+  { return vptr_ == &vtable_for<T>; }
+
+  template <typename T>
+  T& unsafe_get()
+  { return *static_cast<T*>(ptr_); }
+
+  ~queryable_vehicle()
+  { if (ptr_ != nullptr) vptr_->delete_(ptr_); }
+};
+
+// `inheritance_vehicle` hides its pointer, which we need to cast.
+struct virtual_vehicle {
+  template <typename Any>
+  virtual_vehicle(Any vehicle)
+    : ptr{std::make_unique<Derived<Any>>(std::move(vehicle))}
+  { }
+
+  std::unique_ptr<VirtualVehicle> ptr;
+};
+
+// Creates `n` vehicles, of which `percent_cars` percent are cars and the rest
+// is split between trucks and planes, in a random order.
+template <typename Vehicle>
+std::vector<Vehicle> make_vehicles(std::size_t n, int percent_cars) {
+  std::mt19937 rng{12345};
+  std::uniform_int_distribution<int> percent{0, 99};
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    int const p = percent(rng);
+    if (p < percent_cars)  vehicles.push_back(Car{"Audi", 2017});
+    else if (p % 2)        vehicles.push_back(Truck{"Chevrolet", 2015});
+    else                   vehicles.push_back(Plane{"Boeing", "747"});
+  }
+  return vehicles;
+}
+
+template <typename Vehicle, typename Accelerate>
+void run(benchmark::State& state, Accelerate accelerate) {
+  std::size_t const n = state.range(0);
+  std::vector<Vehicle> vehicles = make_vehicles<Vehicle>(n, state.range(1));
+  while (state.KeepRunning()) {
+    for (auto& vehicle : vehicles)
+      accelerate(vehicle);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+void vtable_dispatch(benchmark::State& state) {
+  run<queryable_vehicle>(state, [](queryable_vehicle& v) { v.accelerate(); });
+}
+
+void vtable_fast_path(benchmark::State& state) {
+  run<queryable_vehicle>(state, [](queryable_vehicle& v) {
+    if (v.holds<Car>()) v.unsafe_get<Car>().accelerate();
+    else                v.accelerate();
+  });
+}
+
+void virtual_dispatch(benchmark::State& state) {
+  run<virtual_vehicle>(state, [](virtual_vehicle& v) {
+    v.ptr->accelerate();
+  });
+}
+
+void dynamic_cast_fast_path(benchmark::State& state) {
+  run<virtual_vehicle>(state, [](virtual_vehicle& v) {
+    if (auto* car = dynamic_cast<Derived<Car>*>(v.ptr.get()))
+      car->vehicle.accelerate();
+    else
+      v.ptr->accelerate();
+  });
+}
+
+void typeid_fast_path(benchmark::State& state) {
+  run<virtual_vehicle>(state, [](virtual_vehicle& v) {
+    if (typeid(*v.ptr) == typeid(Derived<Car>))
+      static_cast<Derived<Car>&>(*v.ptr).vehicle.accelerate();
+    else
+      v.ptr->accelerate();
+  });
+}
+
+void mix(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"size", "percent_cars"});
+  for (long percent_cars : {50, 90, 99})
+    b->Args({1 << 16, percent_cars});
+}
+
+BENCHMARK(vtable_dispatch)->Apply(mix);
+BENCHMARK(vtable_fast_path)->Apply(mix);
+BENCHMARK(virtual_dispatch)->Apply(mix);
+BENCHMARK(dynamic_cast_fast_path)->Apply(mix);
+BENCHMARK(typeid_fast_path)->Apply(mix);
+
+BENCHMARK_MAIN();
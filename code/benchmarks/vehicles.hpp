@@ -0,0 +1,129 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef BENCHMARKS_VEHICLES_HPP
+#define BENCHMARKS_VEHICLES_HPP
+
+#include "dispatch_trace.hpp"
+#include "vtable.dyno.hpp"
+
+#include <dyno.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+using namespace dyno::literals;
+
+
+// The vehicles used in the benchmarks. Unlike in the examples, accelerating
+// does not print anything, so that we measure the cost of dispatching.
+struct Car {
+  std::string make;
+  int year;
+  int speed = 0;
+  void accelerate() { speed += 1; }
+};
+
+struct Truck {
+  std::string make;
+  int year;
+  int speed = 0;
+  void accelerate() { speed += 2; }
+};
+
+struct Plane {
+  std::string make;
+  std::string model;
+  int speed = 0;
+  void accelerate() { speed += 3; }
+};
+
+// Large enough to store any of the vehicles above in place. Their size
+// depends on the standard library; a `Plane` is 72 bytes with libstdc++.
+constexpr std::size_t vehicle_size =
+  std::max({sizeof(Car), sizeof(Truck), sizeof(Plane)});
+
+// A Vehicle for each combination of storage policy and vtable layout.
+//
+// When compiled with `-DTRACE_DISPATCH`, vehicles remember the type they were
+// created from and record their dispatches in the current `dispatch_trace`.
+template <typename Storage,
+          typename VTable = dyno::vtable<dyno::remote<dyno::everything>>>
+struct Vehicle {
+  template <typename Any>
+  Vehicle(Any vehicle)
+    : poly_{std::move(vehicle)}
+#if defined(TRACE_DISPATCH)
+    , type_{dispatch_type_id<Any>()}
+#endif
+  { }
+
+  void accelerate() {
+#if defined(TRACE_DISPATCH)
+    trace_dispatch(type_, dispatch_method::accelerate, this);
+#endif
+    poly_.virtual_("accelerate"_s)(poly_);
+  }
+
+private:
+  dyno::poly<IVehicle, Storage, VTable> poly_;
+#if defined(TRACE_DISPATCH)
+  std::uint32_t type_;
+#endif
+};
+
+using remote_storage_vehicle = Vehicle<dyno::remote_storage>;
+using sbo_storage_vehicle = Vehicle<dyno::sbo_storage<16>>;
+using local_storage_vehicle = Vehicle<dyno::local_storage<vehicle_size>>;
+using shared_remote_storage_vehicle = Vehicle<dyno::shared_remote_storage>;
+using local_vtable_vehicle = Vehicle<
+  dyno::remote_storage,
+  dyno::vtable<dyno::local<dyno::everything>>
+>;
+using joined_vtable_vehicle = Vehicle<
+  dyno::remote_storage,
+  dyno::vtable<dyno::local<dyno::only<decltype("accelerate"_s)>>,
+               dyno::remote<dyno::everything_else>>
+>;
+
+// Classic inheritance, for comparison. The vehicles are wrapped in a class
+// deriving from a virtual base, and held through a `std::unique_ptr`.
+struct VirtualVehicle {
+  virtual void accelerate() = 0;
+  virtual ~VirtualVehicle() { }
+};
+
+template <typename T>
+struct Derived final : VirtualVehicle {
+  explicit Derived(T v) : vehicle{std::move(v)} { }
+  void accelerate() override { vehicle.accelerate(); }
+  T vehicle;
+};
+
+struct inheritance_vehicle {
+  template <typename Any>
+  inheritance_vehicle(Any vehicle)
+    : ptr_{std::make_unique<Derived<Any>>(std::move(vehicle))}
+#if defined(TRACE_DISPATCH)
+    , type_{dispatch_type_id<Any>()}
+#endif
+  { }
+
+  void accelerate() {
+#if defined(TRACE_DISPATCH)
+    trace_dispatch(type_, dispatch_method::accelerate, this);
+#endif
+    ptr_->accelerate();
+  }
+
+private:
+  std::unique_ptr<VirtualVehicle> ptr_;
+#if defined(TRACE_DISPATCH)
+  std::uint32_t type_;
+#endif
+};
+
+#endif // header guard
@@ -0,0 +1,190 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// `IVehicle` has a single method, which always favors putting the vtable in
+// the object. This benchmark uses concepts with 1, 4, 16 and 64 methods to
+// find the point where a local vtable makes objects so large that the extra
+// cache misses outweigh the saved indirection. For each vtable layout, it
+// measures the size of the objects, the cost of copying them and the cost of
+// calling one (`call_hot`) or all (`call_all`) of their methods, with more and
+// more objects to increase the cache pressure.
+
+#include "perf_counters.hpp"
+
+#include <benchmark/benchmark.h>
+#include <dyno.hpp>
+
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+using namespace dyno::literals;
+
+
+// The names of the methods beyond the first one, for each concept.
+#define METHODS_1(X)
+#define METHODS_4(X) \
+  X(1, "m1"_s) X(2, "m2"_s) X(3, "m3"_s)
+#define METHODS_16(X) \
+  METHODS_4(X) \
+  X(4, "m4"_s) X(5, "m5"_s) X(6, "m6"_s) X(7, "m7"_s) X(8, "m8"_s) \
+  X(9, "m9"_s) X(10, "m10"_s) X(11, "m11"_s) X(12, "m12"_s) \
+  X(13, "m13"_s) X(14, "m14"_s) X(15, "m15"_s)
+#define METHODS_64(X) \
+  METHODS_16(X) \
+  X(16, "m16"_s) X(17, "m17"_s) X(18, "m18"_s) X(19, "m19"_s) \
+  X(20, "m20"_s) X(21, "m21"_s) X(22, "m22"_s) X(23, "m23"_s) \
+  X(24, "m24"_s) X(25, "m25"_s) X(26, "m26"_s) X(27, "m27"_s) \
+  X(28, "m28"_s) X(29, "m29"_s) X(30, "m30"_s) X(31, "m31"_s) \
+  X(32, "m32"_s) X(33, "m33"_s) X(34, "m34"_s) X(35, "m35"_s) \
+  X(36, "m36"_s) X(37, "m37"_s) X(38, "m38"_s) X(39, "m39"_s) \
+  X(40, "m40"_s) X(41, "m41"_s) X(42, "m42"_s) X(43, "m43"_s) \
+  X(44, "m44"_s) X(45, "m45"_s) X(46, "m46"_s) X(47, "m47"_s) \
+  X(48, "m48"_s) X(49, "m49"_s) X(50, "m50"_s) X(51, "m51"_s) \
+  X(52, "m52"_s) X(53, "m53"_s) X(54, "m54"_s) X(55, "m55"_s) \
+  X(56, "m56"_s) X(57, "m57"_s) X(58, "m58"_s) X(59, "m59"_s) \
+  X(60, "m60"_s) X(61, "m61"_s) X(62, "m62"_s) X(63, "m63"_s)
+
+#define DECLARE_METHOD(i, name) , name = dyno::function<void (dyno::T&)>
+#define DEFINE_METHOD(i, name) , name = [](T& self) { self.speed += i; }
+#define CALL_METHOD(i, name) poly.virtual_(name)(poly);
+
+// Defines `Concept<M>` with methods m0, ..., m<M-1>, its concept map for any
+// type with a `speed`, and `call_every_method(poly, Concept<M>)`, which calls
+// every method once.
+template <int Methods>
+struct Concept;
+
+#define DEFINE_CONCEPT(M)                                                    \
+  template <>                                                                \
+  struct Concept<M> : decltype(dyno::requires(                               \
+    dyno::CopyConstructible{},                                               \
+    dyno::Destructible{},                                                    \
+    "m0"_s = dyno::function<void (dyno::T&)>                                 \
+    METHODS_##M(DECLARE_METHOD)                                              \
+  )) { };                                                                    \
+                                                                             \
+  template <typename T>                                                      \
+  auto const dyno::default_concept_map<Concept<M>, T> =                      \
+    dyno::make_concept_map(                                                  \
+      "m0"_s = [](T& self) { self.speed += 1; }                              \
+      METHODS_##M(DEFINE_METHOD)                                             \
+    );                                                                       \
+                                                                             \
+  template <typename Poly>                                                   \
+  void call_every_method(Poly& poly, Concept<M>) {                           \
+    poly.virtual_("m0"_s)(poly);                                             \
+    METHODS_##M(CALL_METHOD)                                                 \
+  }
+
+DEFINE_CONCEPT(1)
+DEFINE_CONCEPT(4)
+DEFINE_CONCEPT(16)
+DEFINE_CONCEPT(64)
+
+// A few distinct types, so that calls are not trivially predicted.
+template <int K>
+struct Widget {
+  long speed = K;
+};
+
+using remote_vtable = dyno::vtable<dyno::remote<dyno::everything>>;
+using local_vtable = dyno::vtable<dyno::local<dyno::everything>>;
+using joined_vtable = dyno::vtable<
+  dyno::local<dyno::only<decltype("m0"_s)>>,
+  dyno::remote<dyno::everything_else>
+>;
+
+template <int Methods, typename VTable>
+using Object = dyno::poly<Concept<Methods>, dyno::remote_storage, VTable>;
+
+template <typename Object>
+std::vector<Object> make_objects(std::size_t n) {
+  std::mt19937 rng{12345};
+  std::uniform_int_distribution<int> type{0, 3};
+  std::vector<Object> objects;
+  objects.reserve(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    switch (type(rng)) {
+      case 0: objects.push_back(Object{Widget<0>{}}); break;
+      case 1: objects.push_back(Object{Widget<1>{}}); break;
+      case 2: objects.push_back(Object{Widget<2>{}}); break;
+      case 3: objects.push_back(Object{Widget<3>{}}); break;
+    }
+  }
+  return objects;
+}
+
+template <int Methods, typename VTable>
+void report_size(benchmark::State& state) {
+  state.counters["object-bytes"] = sizeof(Object<Methods, VTable>);
+}
+
+// Copies a collection of objects.
+template <int Methods, typename VTable>
+void copy(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  auto const objects = make_objects<Object<Methods, VTable>>(n);
+  while (state.KeepRunning()) {
+    auto copies = objects;
+    benchmark::DoNotOptimize(copies.data());
+  }
+  report_size<Methods, VTable>(state);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Calls the same method on every object.
+template <int Methods, typename VTable>
+void call_hot(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  auto objects = make_objects<Object<Methods, VTable>>(n);
+  perf_counters counters;
+  counters.start();
+  while (state.KeepRunning()) {
+    for (auto& object : objects)
+      object.virtual_("m0"_s)(object);
+    benchmark::ClobberMemory();
+  }
+  counters.stop();
+  counters.report(state, n);
+  report_size<Methods, VTable>(state);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Calls every method on every object.
+template <int Methods, typename VTable>
+void call_all(benchmark::State& state) {
+  std::size_t const n = state.range(0);
+  auto objects = make_objects<Object<Methods, VTable>>(n);
+  perf_counters counters;
+  counters.start();
+  while (state.KeepRunning()) {
+    for (auto& object : objects)
+      call_every_method(object, Concept<Methods>{});
+    benchmark::ClobberMemory();
+  }
+  counters.stop();
+  counters.report(state, n * Methods);
+  report_size<Methods, VTable>(state);
+  state.SetItemsProcessed(state.iterations() * n * Methods);
+}
+
+#define BENCHMARK_LAYOUT(Methods, VTable)                                    \
+  BENCHMARK_TEMPLATE(copy, Methods, VTable)                                  \
+    ->RangeMultiplier(16)->Range(1 << 8, 1 << 20);                           \
+  BENCHMARK_TEMPLATE(call_hot, Methods, VTable)                              \
+    ->RangeMultiplier(16)->Range(1 << 8, 1 << 20);                           \
+  BENCHMARK_TEMPLATE(call_all, Methods, VTable)                              \
+    ->RangeMultiplier(16)->Range(1 << 8, 1 << 20)
+
+#define BENCHMARK_METHODS(Methods)                                           \
+  BENCHMARK_LAYOUT(Methods, remote_vtable);                                  \
+  BENCHMARK_LAYOUT(Methods, local_vtable);                                   \
+  BENCHMARK_LAYOUT(Methods, joined_vtable)
+
+BENCHMARK_METHODS(1);
+BENCHMARK_METHODS(4);
+BENCHMARK_METHODS(16);
+BENCHMARK_METHODS(64);
+
+BENCHMARK_MAIN();
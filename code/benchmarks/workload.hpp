@@ -0,0 +1,124 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef BENCHMARKS_WORKLOAD_HPP
+#define BENCHMARKS_WORKLOAD_HPP
+
+// Generates collections of vehicles whose mix of concrete types is more
+// realistic than Car, Truck, Plane in order. The number of distinct types,
+// how often each of them appears, and the order in which they appear can all
+// be controlled, since this is what decides how well the branch predictor
+// handles the indirect calls.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+// The maximum number of distinct concrete types in a workload.
+constexpr std::size_t max_types = 256;
+
+// A family of concrete vehicle types. Each `Kind<I>` has its own
+// `accelerate()`, so dispatching to them goes through distinct functions.
+template <std::size_t I>
+struct Kind {
+  long speed = 0;
+  long distance = 0;
+  void accelerate() { speed += static_cast<long>(I) + 1; distance += speed; }
+};
+
+enum class ordering {
+  sorted,    // all the objects of a type are next to each other
+  clustered, // runs of objects of the same type, in random order
+  shuffled   // fully random order
+};
+
+struct workload {
+  std::size_t size;       // number of objects in the collection
+  std::size_t types;      // number of distinct types, in [1, max_types]
+  double zipf;            // Zipf exponent; 0 means all types are equally likely
+  ordering order;
+  std::size_t cluster = 16; // length of the runs with `ordering::clustered`
+  std::uint32_t seed = 12345;
+};
+
+// Returns the index of the concrete type of each object in the collection.
+inline std::vector<std::size_t> make_type_sequence(workload const& w) {
+  std::size_t const types = std::max<std::size_t>(1,
+                              std::min(w.types, max_types));
+  std::vector<double> weights(types);
+  for (std::size_t k = 0; k != types; ++k)
+    weights[k] = 1.0 / std::pow(static_cast<double>(k + 1), w.zipf);
+
+  std::mt19937 rng{w.seed};
+  std::discrete_distribution<std::size_t> distribution(weights.begin(),
+                                                       weights.end());
+  std::vector<std::size_t> sequence(w.size);
+  for (auto& type : sequence)
+    type = distribution(rng);
+
+  switch (w.order) {
+    case ordering::sorted:
+      std::sort(sequence.begin(), sequence.end());
+      break;
+
+    case ordering::clustered: {
+      // Sort, cut into runs of `cluster` objects, and shuffle the runs.
+      std::sort(sequence.begin(), sequence.end());
+      std::size_t const cluster = std::max<std::size_t>(1, w.cluster);
+      std::vector<std::size_t> runs;
+      for (std::size_t i = 0; i < sequence.size(); i += cluster)
+        runs.push_back(i);
+      std::shuffle(runs.begin(), runs.end(), rng);
+
+      std::vector<std::size_t> clustered;
+      clustered.reserve(sequence.size());
+      for (std::size_t start : runs) {
+        std::size_t const end = std::min(start + cluster, sequence.size());
+        clustered.insert(clustered.end(), sequence.begin() + start,
+                                          sequence.begin() + end);
+      }
+      sequence = std::move(clustered);
+      break;
+    }
+
+    case ordering::shuffled:
+      std::shuffle(sequence.begin(), sequence.end(), rng);
+      break;
+  }
+  return sequence;
+}
+
+namespace workload_detail {
+  template <typename Vehicle, std::size_t I>
+  Vehicle make_kind() { return Vehicle{Kind<I>{}}; }
+
+  template <typename Vehicle, std::size_t ...I>
+  constexpr std::array<Vehicle (*)(), sizeof...(I)>
+  make_factories(std::index_sequence<I...>)
+  { return {{&make_kind<Vehicle, I>...}}; }
+} // end namespace workload_detail
+
+// Builds a collection of `Vehicle`s from the types returned by
+// `make_type_sequence`.
+template <typename Vehicle>
+std::vector<Vehicle> make_vehicles(std::vector<std::size_t> const& types) {
+  static constexpr auto factories = workload_detail::make_factories<Vehicle>(
+    std::make_index_sequence<max_types>{});
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(types.size());
+  for (std::size_t type : types)
+    vehicles.push_back(factories[type]());
+  return vehicles;
+}
+
+template <typename Vehicle>
+std::vector<Vehicle> make_vehicles(workload const& w)
+{ return make_vehicles<Vehicle>(make_type_sequence(w)); }
+
+#endif // header guard
@@ -0,0 +1,83 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "biased_shared_storage.hpp"
+#include "function.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+
+// sample(biased_function)
+template <typename Signature>
+using biased_function = basic_function<Signature,
+                                       biased_shared_remote_storage>;
+// end-sample
+
+std::atomic<int> destroyed{0};
+
+struct Add {
+  Add(int n) : n{n} { }
+  Add(Add const&) = default;
+  Add(Add&& other) : n{other.n}, live{other.live} { other.live = false; }
+  ~Add() { if (live) ++destroyed; }
+  int operator()(int i) const { return i + n; }
+  int n;
+  bool live = true;
+};
+
+// sample(main)
+int main() {
+  biased_function<int(int)> const add{Add{1}};
+
+  // Copies made by the owning thread don't need atomic operations, while
+  // the copies made by the workers go through the shared counter.
+  std::vector<std::thread> workers;
+  for (int t = 0; t != 8; ++t) {
+    workers.emplace_back([f = add] {
+      std::vector<biased_function<int(int)>> copies;
+      for (int i = 0; i != 1000; ++i) {
+        copies.push_back(f);
+        assert(copies.back()(i) == i + 1);
+      }
+    });
+  }
+  for (auto& worker : workers)
+    worker.join();
+// end-sample
+
+  // The copies handed to the workers were counted by the owner, but
+  // released by the workers.
+  assert(destroyed == 0);
+  assert(add(41) == 42);
+
+  // An object whose owner exits while other threads still reference it.
+  {
+    std::vector<biased_function<int(int)>> survivors;
+    std::thread{[&] {
+      biased_function<int(int)> const f{Add{2}};
+      survivors.push_back(f);
+    }}.join();
+    assert(destroyed == 0);
+    assert(survivors.back()(40) == 42);
+  }
+  assert(destroyed == 1);
+
+  // An object whose references counted by the owner are all released by
+  // other threads is reclaimed at the owner's next safe point.
+  {
+    std::vector<biased_function<int(int)>> handoff;
+    {
+      biased_function<int(int)> const f{Add{3}};
+      handoff.push_back(f);
+      handoff.push_back(f);
+    }
+    std::thread{[handoff = std::move(handoff)] { }}.join();
+    biased_shared_remote_storage::collect();
+    assert(destroyed == 2);
+  }
+// sample(main)
+}
+// end-sample
@@ -0,0 +1,271 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef BIASED_SHARED_STORAGE_HPP
+#define BIASED_SHARED_STORAGE_HPP
+
+// A storage policy like `dyno::shared_remote_storage`, but with a biased
+// reference count: most objects are only ever copied by the thread that
+// created them, so that thread (the owner) counts its references with plain
+// increments, and only the other threads pay for atomic operations on a
+// separate, shared counter.
+//
+// The true number of references is `biased + shared`. The two counts are
+// merged into the shared one when the owner drops its last reference, and
+// from then on the object is reference counted like any shared object.
+// However, a reference copied by the owner may be released by another thread,
+// driving the shared count negative while the biased count stays positive.
+// Since only the owner may touch the biased count, the object is then queued
+// for the owner, which merges it at its next safe point: when it creates a
+// new object, when it drops the last reference to one of its objects, when
+// it calls `collect()` or when it exits.
+
+#include <dyno.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace biased_detail {
+  struct owner_queue;
+
+  struct control_block {
+    // Identifies the owner, and keeps its queue alive for objects that
+    // outlive it.
+    std::shared_ptr<owner_queue> const owner;
+    void (*destroy)(void* object);
+    std::intptr_t biased;              // only ever touched by the owner
+    std::atomic<std::intptr_t> shared; // count * one + queued + merged
+  };
+
+  constexpr std::intptr_t merged = 1; // the biased count has been merged
+  constexpr std::intptr_t queued = 2; // the object was queued for merging
+  constexpr std::intptr_t one = 4;
+
+  inline std::intptr_t count(std::intptr_t shared)
+  { return (shared - (shared & (merged | queued))) / one; }
+
+  // The object is stored right after its control block.
+  constexpr std::size_t header_size =
+    (sizeof(control_block) + alignof(std::max_align_t) - 1)
+      & ~(alignof(std::max_align_t) - 1);
+
+  inline void* object(control_block* block)
+  { return reinterpret_cast<char*>(block) + header_size; }
+
+  inline void deallocate(control_block* block) {
+    block->destroy(object(block));
+    block->~control_block();
+    std::free(block);
+  }
+
+  // Objects released by other threads, waiting to be merged by their owner.
+  struct owner_queue {
+    std::mutex mutex;
+    std::vector<control_block*> pending;
+    std::atomic<bool> has_pending{false};
+    bool exited = false;
+  };
+
+  // Adds the biased count to the shared count. Must be called by the owner,
+  // or by anyone once the owner has exited.
+  inline void merge(control_block* block) {
+    std::intptr_t const biased = block->biased;
+    block->biased = 0;
+    std::intptr_t const old = block->shared.fetch_add(
+      biased * one + merged, std::memory_order_acq_rel);
+    if (count(old) + biased == 0)
+      deallocate(block);
+  }
+
+  inline void drain(owner_queue& queue) {
+    if (!queue.has_pending.load(std::memory_order_acquire))
+      return;
+    std::vector<control_block*> pending;
+    {
+      std::lock_guard<std::mutex> lock{queue.mutex};
+      pending.swap(queue.pending);
+      queue.has_pending.store(false, std::memory_order_relaxed);
+    }
+    for (control_block* block : pending)
+      merge(block);
+  }
+
+  inline void enqueue(control_block* block) {
+    owner_queue& queue = *block->owner;
+    {
+      std::lock_guard<std::mutex> lock{queue.mutex};
+      if (!queue.exited) {
+        queue.pending.push_back(block);
+        queue.has_pending.store(true, std::memory_order_release);
+        return;
+      }
+    }
+    // The owner is gone, so its biased count can't change anymore, and the
+    // lock made its last value visible to us.
+    merge(block);
+  }
+
+  struct thread_state {
+    std::shared_ptr<owner_queue> queue = std::make_shared<owner_queue>();
+
+    ~thread_state() {
+      std::vector<control_block*> pending;
+      {
+        std::lock_guard<std::mutex> lock{queue->mutex};
+        pending.swap(queue->pending);
+        queue->exited = true;
+      }
+      for (control_block* block : pending)
+        merge(block);
+    }
+  };
+
+  inline thread_state& this_thread() {
+    thread_local thread_state state;
+    return state;
+  }
+} // end namespace biased_detail
+
+// sample(biased_shared_remote_storage)
+class biased_shared_remote_storage {
+  using control_block = biased_detail::control_block;
+
+  static bool is_owner(control_block const* block)
+  { return block->owner == biased_detail::this_thread().queue; }
+
+  static void acquire(control_block* block) {
+    if (is_owner(block) && block->biased > 0)
+      ++block->biased; // no atomic operation
+    else
+      block->shared.fetch_add(biased_detail::one, std::memory_order_relaxed);
+  }
+
+  static void release(control_block* block) {
+    if (is_owner(block) && block->biased > 0) {
+      if (--block->biased == 0) // no atomic operation
+        owner_merge(block);
+    } else {
+      shared_release(block);
+    }
+  }
+// end-sample
+
+  // Called by the owner when it drops the last reference it counted.
+  static void owner_merge(control_block* block) {
+    using namespace biased_detail;
+    owner_queue& queue = *block->owner;
+    std::intptr_t old = block->shared.load(std::memory_order_relaxed);
+    do {
+      if (old & queued) { // already waiting in the queue
+        drain(queue);
+        return;
+      }
+    } while (!block->shared.compare_exchange_weak(old, old | merged,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed));
+    if (count(old) == 0)
+      deallocate(block);
+    drain(queue);
+  }
+
+  static void shared_release(control_block* block) {
+    using namespace biased_detail;
+    std::intptr_t old = block->shared.load(std::memory_order_relaxed);
+    std::intptr_t desired;
+    bool needs_merge;
+    do {
+      desired = old - one;
+      // The owner still counts references that nobody holds anymore.
+      needs_merge = !(old & (merged | queued)) && count(desired) < 0;
+      if (needs_merge)
+        desired |= queued;
+    } while (!block->shared.compare_exchange_weak(old, desired,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed));
+    if ((desired & merged) && count(desired) == 0)
+      deallocate(block);
+    else if (needs_merge && is_owner(block))
+      merge(block);
+    else if (needs_merge)
+      enqueue(block);
+  }
+
+public:
+  template <typename T, typename RawT = std::decay_t<T>>
+  explicit biased_shared_remote_storage(T&& t) {
+    static_assert(alignof(RawT) <= alignof(std::max_align_t),
+      "over-aligned types are not supported");
+    auto& state = biased_detail::this_thread();
+    biased_detail::drain(*state.queue);
+
+    void* memory = std::malloc(biased_detail::header_size + sizeof(RawT));
+    if (memory == nullptr)
+      throw std::bad_alloc{};
+    block_ = new (memory) control_block{
+      state.queue, [](void* p) { static_cast<RawT*>(p)->~RawT(); }, 1, {0}
+    };
+    try {
+      new (get()) RawT(std::forward<T>(t));
+    } catch (...) {
+      block_->~control_block();
+      std::free(memory);
+      throw;
+    }
+  }
+
+  template <typename VTable>
+  biased_shared_remote_storage(biased_shared_remote_storage const& other,
+                               VTable const&)
+    : block_{other.block_}
+  { acquire(block_); }
+
+  template <typename VTable>
+  biased_shared_remote_storage(biased_shared_remote_storage&& other,
+                               VTable const&)
+    : block_{other.block_}
+  { other.block_ = nullptr; }
+
+  template <typename MyVTable, typename OtherVTable>
+  void swap(MyVTable const&, biased_shared_remote_storage& other,
+            OtherVTable const&)
+  { std::swap(block_, other.block_); }
+
+  // The object is destroyed through the function recorded when it was
+  // created, since the last reference may be released by the owner while
+  // it merges an unrelated object.
+  template <typename VTable>
+  void destruct(VTable const&) {
+    if (block_ != nullptr)
+      release(block_);
+  }
+
+  template <typename T = void>
+  T* get()
+  { return static_cast<T*>(biased_detail::object(block_)); }
+
+  template <typename T = void>
+  T const* get() const
+  { return static_cast<T const*>(biased_detail::object(block_)); }
+
+  static constexpr bool can_store(dyno::storage_info) { return true; }
+
+  // Merges the objects owned by this thread whose last references were
+  // released by other threads, destroying them if nobody references them
+  // anymore.
+  static void collect()
+  { biased_detail::drain(*biased_detail::this_thread().queue); }
+
+private:
+  control_block* block_;
+};
+
+#endif // header guard
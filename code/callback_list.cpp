@@ -0,0 +1,155 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "callback_list.hpp"
+#include "function.hpp"
+
+#include <cassert>
+#include <vector>
+
+
+struct Event { int value; };
+
+struct Sum {
+  int* total;
+  void operator()(Event const& e) const { *total += e.value; }
+};
+
+struct Count {
+  int* count;
+  void operator()(Event const&) const { ++*count; }
+};
+
+int main() {
+  // Callbacks of the same type are grouped together
+  {
+    callback_list<void(Event const&)> on_event;
+    int total = 0, count = 0;
+    on_event.subscribe(Sum{&total});
+    on_event.subscribe(Count{&count});
+    on_event.subscribe(Sum{&total});
+    on_event.subscribe(function<void(Event const&)>{Count{&count}});
+    assert(on_event.size() == 4);
+    assert(on_event.groups() == 3);
+
+    on_event(Event{5});
+    assert(total == 10);
+    assert(count == 2);
+  }
+
+  // Handles stay valid when other callbacks are unsubscribed
+  {
+    callback_list<void(Event const&)> on_event;
+    std::vector<int> totals(10);
+    std::vector<callback_list<void(Event const&)>::handle> handles;
+    for (int& total : totals)
+      handles.push_back(on_event.subscribe(Sum{&total}));
+
+    assert(on_event.unsubscribe(handles[0]));
+    assert(on_event.unsubscribe(handles[4]));
+    assert(!on_event.unsubscribe(handles[4]));
+    assert(on_event.size() == 8);
+
+    on_event(Event{1});
+    for (int i = 0; i != 10; ++i)
+      assert(totals[i] == (i == 0 || i == 4 ? 0 : 1));
+
+    assert(on_event.unsubscribe(handles[9]));
+    assert(on_event.unsubscribe(handles[1]));
+    on_event(Event{1});
+    for (int i = 0; i != 10; ++i)
+      assert(totals[i] == (i == 0 || i == 4 ? 0 : i == 1 || i == 9 ? 1 : 2));
+  }
+
+  // A handle whose slot was reused doesn't unsubscribe the new callback
+  {
+    callback_list<void(Event const&)> on_event;
+    int total = 0;
+    auto first = on_event.subscribe(Sum{&total});
+    assert(on_event.unsubscribe(first));
+    auto second = on_event.subscribe(Sum{&total});
+    assert(!on_event.unsubscribe(first));
+    on_event(Event{3});
+    assert(total == 3);
+    assert(on_event.unsubscribe(second));
+  }
+
+  // Callbacks can subscribe and unsubscribe during a broadcast
+  {
+    using List = callback_list<void(Event const&)>;
+    List on_event;
+    int total = 0, count = 0;
+    List::handle self{}, victim{};
+    auto late = [&](Event const&) { ++count; };
+
+    self = on_event.subscribe([&](Event const&) {
+      on_event.subscribe(Sum{&total});    // existing group
+      on_event.subscribe(late);           // new group
+      on_event.unsubscribe(victim);       // not called anymore
+      on_event.unsubscribe(self);         // currently running
+    });
+    victim = on_event.subscribe(Sum{&total});
+
+    on_event(Event{1});
+    assert(total == 0);
+    assert(count == 0);
+    assert(on_event.size() == 2);
+
+    on_event(Event{1});
+    assert(total == 1);
+    assert(count == 1);
+  }
+
+  // Subscribing then unsubscribing during the same broadcast
+  {
+    using List = callback_list<void(Event const&)>;
+    List on_event;
+    int total = 0;
+    bool once = true;
+    on_event.subscribe([&](Event const&) {
+      if (once) {
+        once = false;
+        List::handle a = on_event.subscribe(Sum{&total});
+        on_event.subscribe(Sum{&total});
+        on_event.unsubscribe(a);
+      }
+    });
+    on_event(Event{1});
+    on_event(Event{2});
+    assert(total == 2);
+    assert(on_event.size() == 2);
+  }
+
+  // Slots freed during a broadcast can be reused by callbacks of another group
+  {
+    using List = callback_list<void(Event const&)>;
+    using Function = function<void(Event const&)>;
+    List on_event;
+    int first = 0, second = 0, ignored = 0;
+    List::handle a0{}, a2{}, b1{};
+    on_event.subscribe(Count{&first});
+    a0 = on_event.subscribe(Function{[&](Event const&) {
+      on_event.unsubscribe(a0);
+      on_event.unsubscribe(a2);
+      b1 = on_event.subscribe(Count{&second}); // reuses the slot of a2
+    }});
+    on_event.subscribe(Function{Count{&ignored}});
+    a2 = on_event.subscribe(Function{Count{&ignored}});
+
+    on_event(Event{1});
+    assert(first == 1 && second == 0);
+    assert(on_event.unsubscribe(b1));
+    on_event(Event{1});
+    assert(first == 2 && second == 0);
+  }
+
+  // Default-constructed handles don't refer to any callback
+  {
+    callback_list<void(Event const&)> on_event;
+    int total = 0;
+    on_event.subscribe(Sum{&total});
+    assert(!on_event.unsubscribe(callback_list<void(Event const&)>::handle{}));
+    on_event(Event{1});
+    assert(total == 1);
+  }
+}
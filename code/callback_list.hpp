@@ -0,0 +1,298 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef CALLBACK_LIST_HPP
+#define CALLBACK_LIST_HPP
+
+// A list of callbacks to call when an event is broadcast, like a
+// `std::vector<function<void(Event const&)>>`, but where the callbacks are
+// grouped by type:
+//
+//  group of OnClick:  | OnClick | OnClick | OnClick |
+//  group of Logger:   | Logger | Logger |
+//
+// The callbacks of a group are stored contiguously and called in a loop
+// where their type is known, so broadcasting costs one indirect call per
+// group instead of one per callback, and no callback lives on the heap by
+// itself. Callbacks can be of any type modeling `Callable<void(Args...)>`
+// (see `function.hpp`), including a `function` itself.
+//
+// Subscribing returns a handle that stays valid however the callbacks move
+// inside their group, and unsubscribing with it takes constant time. Both
+// can be done by callbacks during a broadcast: callbacks subscribed during
+// a broadcast are first called by the next one, and callbacks unsubscribed
+// during a broadcast are not called anymore, even by that broadcast.
+
+#include "function.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+template <typename Signature>
+class callback_list;
+
+template <typename ...Args>
+class callback_list<void(Args...)> {
+public:
+  struct handle {
+    std::uint32_t slot;
+    std::uint32_t generation;
+  };
+
+private:
+  // Where the callback of a handle currently is.
+  struct slot {
+    std::uint32_t group;
+    std::uint32_t index;      // in the callbacks of the group, or its pending ones
+    std::uint32_t generation; // changes when the slot is freed, never 0
+    bool pending;             // subscribed during a broadcast
+  };
+
+  template <typename F>
+  struct group {
+    std::vector<F> callbacks;
+    std::vector<std::uint32_t> slots;   // the slot of each callback
+    std::vector<char> alive;            // false once unsubscribed in a broadcast
+    std::vector<F> pending;             // subscribed during a broadcast
+    std::vector<std::uint32_t> pending_slots;
+  };
+
+  // sample(group_vtable)
+  struct group_vtable {
+    void (*broadcast)(void* group, Args... args);
+    void (*add)(void* group, void* callback, slot& s, std::uint32_t id);
+    void (*remove)(void* group, std::vector<slot>& slots, slot& s, bool broadcasting);
+    void (*cleanup)(void* group, std::vector<slot>& slots);
+    void (*destroy)(void* group);
+  };
+
+  template <typename F>
+  static void broadcast_to(void* g, Args... args) {
+    group<F>& self = *static_cast<group<F>*>(g);
+    std::size_t const n = self.callbacks.size();
+    for (std::size_t i = 0; i != n; ++i)
+      if (self.alive[i])
+        static_cast<F const&>(self.callbacks[i])(args...); // direct call
+  }
+  // end-sample
+
+  // Adds a callback, or puts it aside if the group is being broadcast to.
+  template <typename F>
+  static void add_to(void* g, void* callback, slot& s, std::uint32_t id) {
+    group<F>& self = *static_cast<group<F>*>(g);
+    F& f = *static_cast<F*>(callback);
+    if (s.pending) {
+      s.index = static_cast<std::uint32_t>(self.pending.size());
+      self.pending.push_back(std::move(f));
+      self.pending_slots.push_back(id);
+    } else {
+      s.index = static_cast<std::uint32_t>(self.callbacks.size());
+      self.callbacks.push_back(std::move(f));
+      self.slots.push_back(id);
+      self.alive.push_back(true);
+    }
+  }
+
+  // Removes the callback at `index` by moving the last one in its place.
+  // Callbacks are move-constructed rather than assigned, since lambdas can't
+  // be assigned.
+  template <typename F>
+  static void swap_and_pop(std::vector<F>& callbacks,
+                           std::vector<std::uint32_t>& ids,
+                           std::vector<slot>& slots, std::size_t index) {
+    if (index != callbacks.size() - 1) {
+      callbacks[index].~F();
+      new (&callbacks[index]) F(std::move(callbacks.back()));
+      ids[index] = ids.back();
+      slots[ids[index]].index = static_cast<std::uint32_t>(index);
+    }
+    callbacks.pop_back();
+    ids.pop_back();
+  }
+
+  // Removes a callback. During a broadcast, the callbacks can't be moved,
+  // since one of them is running, so the callback is only marked as dead.
+  template <typename F>
+  static void remove_from(void* g, std::vector<slot>& slots, slot& s,
+                          bool broadcasting) {
+    group<F>& self = *static_cast<group<F>*>(g);
+    if (s.pending) {
+      swap_and_pop(self.pending, self.pending_slots, slots, s.index);
+    } else if (broadcasting) {
+      self.alive[s.index] = false;
+    } else {
+      self.alive[s.index] = self.alive.back();
+      self.alive.pop_back();
+      swap_and_pop(self.callbacks, self.slots, slots, s.index);
+    }
+  }
+
+  // Reclaims the dead callbacks and adds the pending ones, once nobody is
+  // broadcasting anymore.
+  template <typename F>
+  static void cleanup_of(void* g, std::vector<slot>& slots) {
+    group<F>& self = *static_cast<group<F>*>(g);
+    // The slots of dead callbacks may have been reused by then, so only the
+    // slots of the live callbacks are updated as they are moved down.
+    std::size_t live = 0;
+    for (std::size_t i = 0; i != self.callbacks.size(); ++i) {
+      if (!self.alive[i])
+        continue;
+      if (live != i) {
+        self.callbacks[live].~F();
+        new (&self.callbacks[live]) F(std::move(self.callbacks[i]));
+        self.slots[live] = self.slots[i];
+        slots[self.slots[live]].index = static_cast<std::uint32_t>(live);
+        self.alive[live] = true;
+      }
+      ++live;
+    }
+    while (self.callbacks.size() != live)
+      self.callbacks.pop_back();
+    self.slots.resize(live);
+    self.alive.resize(live);
+
+    for (std::size_t i = 0; i != self.pending.size(); ++i) {
+      slot& s = slots[self.pending_slots[i]];
+      s.pending = false;
+      s.index = static_cast<std::uint32_t>(self.callbacks.size());
+      self.callbacks.push_back(std::move(self.pending[i]));
+      self.slots.push_back(self.pending_slots[i]);
+      self.alive.push_back(true);
+    }
+    self.pending.clear();
+    self.pending_slots.clear();
+  }
+
+  template <typename F>
+  static void destroy(void* g)
+  { delete static_cast<group<F>*>(g); }
+
+  template <typename F>
+  static constexpr group_vtable group_vtable_for = {
+    &broadcast_to<F>, &add_to<F>, &remove_from<F>, &cleanup_of<F>, &destroy<F>
+  };
+
+  struct group_ref {
+    group_vtable const* vptr;
+    void* group;
+  };
+
+public:
+  callback_list() = default;
+  callback_list(callback_list const&) = delete;
+  callback_list& operator=(callback_list const&) = delete;
+
+  ~callback_list() {
+    for (group_ref& g : groups_)
+      g.vptr->destroy(g.group);
+  }
+
+  // Subscribes a callback, which is called by the broadcasts that start
+  // after this call.
+  template <typename F>
+  handle subscribe(F&& f) {
+    using Callback = std::decay_t<F>;
+    static_assert(is_callable<void(Args...), Callback>::value,
+      "callbacks must model Callable<void(Args...)>");
+    std::uint32_t const g = group_of<Callback>();
+
+    std::uint32_t id;
+    if (free_.empty()) {
+      id = static_cast<std::uint32_t>(slots_.size());
+      slots_.push_back(slot{g, 0, 1, false});
+    } else {
+      id = free_.back();
+      free_.pop_back();
+      slots_[id].group = g;
+    }
+    slot& s = slots_[id];
+    s.pending = broadcasting_ != 0;
+    Callback callback(std::forward<F>(f));
+    groups_[g].vptr->add(groups_[g].group, &callback, s, id);
+    if (s.pending)
+      needs_cleanup_ = true;
+    ++size_;
+    return handle{id, s.generation};
+  }
+
+  // Unsubscribes a callback, which won't be called anymore. Returns false if
+  // it was already unsubscribed.
+  bool unsubscribe(handle h) {
+    if (h.slot >= slots_.size() || slots_[h.slot].generation != h.generation)
+      return false;
+    slot& s = slots_[h.slot];
+    group_ref& g = groups_[s.group];
+    bool const deferred = broadcasting_ != 0 && !s.pending;
+    g.vptr->remove(g.group, slots_, s, broadcasting_ != 0);
+    if (deferred)
+      needs_cleanup_ = true;
+    if (++s.generation == 0)
+      s.generation = 1;
+    free_.push_back(h.slot);
+    --size_;
+    return true;
+  }
+
+  // sample(broadcast)
+  void operator()(Args... args) {
+    broadcast_guard guard{*this};
+    for (std::size_t g = 0, n = groups_.size(); g != n; ++g)
+      groups_[g].vptr->broadcast(groups_[g].group, args...);
+  }
+  // end-sample
+
+  std::size_t size() const { return size_; }
+
+  // The number of distinct types of callbacks ever subscribed.
+  std::size_t groups() const { return groups_.size(); }
+
+private:
+  // Keeps track of nested broadcasts, and cleans up after the outermost one,
+  // even if a callback throws.
+  struct broadcast_guard {
+    callback_list& self;
+    explicit broadcast_guard(callback_list& s) : self{s}
+    { ++self.broadcasting_; }
+    ~broadcast_guard() {
+      if (--self.broadcasting_ == 0 && self.needs_cleanup_) {
+        self.needs_cleanup_ = false;
+        for (group_ref& g : self.groups_)
+          g.vptr->cleanup(g.group, self.slots_);
+      }
+    }
+  };
+
+  template <typename F>
+  std::uint32_t group_of() {
+    group_vtable const* vptr = &group_vtable_for<F>;
+    auto it = group_index_.find(vptr);
+    if (it != group_index_.end())
+      return it->second;
+    std::uint32_t const g = static_cast<std::uint32_t>(groups_.size());
+    groups_.push_back(group_ref{vptr, new group<F>{}});
+    group_index_.emplace(vptr, g);
+    return g;
+  }
+
+  std::vector<group_ref> groups_;
+  std::unordered_map<group_vtable const*, std::uint32_t> group_index_;
+  std::vector<slot> slots_;
+  std::vector<std::uint32_t> free_;
+  std::size_t size_ = 0;
+  int broadcasting_ = 0;
+  bool needs_cleanup_ = false;
+};
+
+template <typename ...Args>
+template <typename F>
+constexpr typename callback_list<void(Args...)>::group_vtable
+callback_list<void(Args...)>::group_vtable_for;
+
+#endif // header guard
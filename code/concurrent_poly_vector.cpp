@@ -0,0 +1,118 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "concurrent_poly_vector.hpp"
+#include "vtable.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class Vehicle {
+  vtable const* const vptr_;
+  void* ptr_;
+
+public:
+  template <typename Any>
+  Vehicle(Any vehicle)
+    : vptr_{&vtable_for<Any>}
+    , ptr_{new Any(vehicle)}
+  { }
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}
+    , ptr_{other.vptr_->clone(other.ptr_)}
+  { }
+
+  void accelerate()
+  { vptr_->accelerate(ptr_); }
+
+  ~Vehicle()
+  { vptr_->delete_(ptr_); }
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+constexpr int producers = 8;
+constexpr int per_producer = 5000;
+std::atomic<int> accelerated[producers * per_producer];
+
+struct Car {
+  int id;
+  void accelerate() { ++accelerated[id]; }
+};
+
+struct Truck {
+  int id;
+  std::string make;
+  void accelerate() { ++accelerated[id]; }
+};
+
+// sample(main)
+int main() {
+  concurrent_poly_vector<Vehicle> vehicles;
+  std::vector<std::vector<Vehicle*>> appended(producers);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p != producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i != per_producer; ++i) {
+        int const id = p * per_producer + i;
+        Vehicle& v = i % 2 ? vehicles.push_back(Car{id})
+                           : vehicles.push_back(Truck{id, "Chevrolet"});
+        appended[p].push_back(&v);
+      }
+    });
+  }
+
+  // Readers iterate while the producers are appending.
+  std::size_t visited = 0;
+  while (vehicles.size() != producers * per_producer) {
+    std::size_t n = 0;
+    vehicles.for_each([&](Vehicle&) { ++n; });
+    assert(n >= visited); // published elements stay published
+    visited = n;
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+// end-sample
+
+  // Once the producers are done, every element is visited exactly once.
+  for (auto& count : accelerated)
+    count = 0;
+  std::vector<Vehicle*> addresses;
+  vehicles.for_each([&](Vehicle& v) {
+    v.accelerate();
+    addresses.push_back(&v);
+  });
+  assert(addresses.size() == producers * per_producer);
+  for (auto& count : accelerated)
+    assert(count == 1);
+
+  // The elements never moved after being appended.
+  std::sort(addresses.begin(), addresses.end());
+  for (auto const& addrs : appended)
+    for (Vehicle* v : addrs)
+      assert(std::binary_search(addresses.begin(), addresses.end(), v));
+
+  // Elements appended by a single thread are visited in order.
+  {
+    concurrent_poly_vector<Vehicle, 4> small;
+    for (int i = 0; i != 100; ++i)
+      small.push_back(Car{i});
+    for (auto& count : accelerated)
+      count = 0;
+    int expected = 0;
+    small.for_each([&](Vehicle& v) {
+      v.accelerate();
+      assert(accelerated[expected++] == 1);
+    });
+    assert(expected == 100);
+  }
+}
@@ -0,0 +1,145 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef CONCURRENT_POLY_VECTOR_HPP
+#define CONCURRENT_POLY_VECTOR_HPP
+
+// An append-only collection of type-erased values (e.g. a `Vehicle` using any
+// storage policy) that many threads can append to while others iterate.
+//
+// Elements are stored in segments that are never moved nor freed before the
+// collection is destroyed, so their addresses are stable. The segments double
+// in size, so that a handful of them hold any number of elements:
+//
+//  segment 0: | 0 | 1 | ... | B-1 |
+//  segment 1: | B | B+1 | ... | 3B-1 |
+//  segment 2: | 3B | ... | 7B-1 |
+//
+// Appending reserves an index with a single atomic increment, allocates the
+// segment of that index if nobody did yet, constructs the element in place
+// and then publishes it. Readers only ever look at published elements.
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+template <typename T, std::size_t FirstSegment = 64>
+class concurrent_poly_vector {
+  static_assert((FirstSegment & (FirstSegment - 1)) == 0,
+    "the size of the first segment must be a power of 2");
+
+  // Enough segments for as many elements as can be indexed.
+  static constexpr std::size_t max_segments = 8 * sizeof(std::size_t) - 1;
+
+  struct slot {
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    std::atomic<bool> published;
+
+    T& get() { return *reinterpret_cast<T*>(&storage); }
+  };
+
+public:
+  concurrent_poly_vector() {
+    for (auto& segment : segments_)
+      segment.store(nullptr, std::memory_order_relaxed);
+  }
+
+  concurrent_poly_vector(concurrent_poly_vector const&) = delete;
+  concurrent_poly_vector& operator=(concurrent_poly_vector const&) = delete;
+
+  // Not thread safe: nobody may be using the collection anymore.
+  ~concurrent_poly_vector() {
+    std::size_t const size = reserved_.load(std::memory_order_relaxed);
+    for (std::size_t k = 0; k != max_segments; ++k) {
+      slot* segment = segments_[k].load(std::memory_order_relaxed);
+      if (segment == nullptr)
+        continue;
+      std::size_t const first = segment_start(k);
+      for (std::size_t i = 0; i != segment_size(k) && first + i < size; ++i)
+        if (segment[i].published.load(std::memory_order_relaxed))
+          segment[i].get().~T();
+      ::operator delete(segment);
+    }
+  }
+
+  // sample(emplace_back)
+  // Appends an element and returns it. The returned reference stays valid
+  // for as long as the collection lives. Thread safe.
+  template <typename ...Args>
+  T& emplace_back(Args&& ...args) {
+    std::size_t const index = reserved_.fetch_add(1, std::memory_order_relaxed);
+    std::size_t const k = segment_of(index);
+    slot& s = segment(k)[index - segment_start(k)];
+    T* element = new (&s.storage) T(std::forward<Args>(args)...);
+    s.published.store(true, std::memory_order_release);
+    return *element;
+  }
+  // end-sample
+
+  template <typename Any>
+  T& push_back(Any&& value)
+  { return emplace_back(std::forward<Any>(value)); }
+
+  // sample(for_each)
+  // Calls `f` with every element appended before the call, and maybe some of
+  // the elements appended concurrently, in the order of their indices. Can
+  // run while other threads append.
+  template <typename F>
+  void for_each(F f) {
+    std::size_t const size = reserved_.load(std::memory_order_acquire);
+    for (std::size_t k = 0; segment_start(k) < size; ++k) {
+      slot* segment = segments_[k].load(std::memory_order_acquire);
+      if (segment == nullptr)
+        continue; // still being allocated, so nothing is published there
+      std::size_t const first = segment_start(k);
+      for (std::size_t i = 0; i != segment_size(k) && first + i < size; ++i)
+        if (segment[i].published.load(std::memory_order_acquire))
+          f(segment[i].get());
+    }
+  }
+  // end-sample
+
+  // The number of elements appended or being appended.
+  std::size_t size() const
+  { return reserved_.load(std::memory_order_acquire); }
+
+private:
+  static constexpr std::size_t segment_size(std::size_t k)
+  { return FirstSegment << k; }
+
+  static constexpr std::size_t segment_start(std::size_t k)
+  { return FirstSegment * ((std::size_t(1) << k) - 1); }
+
+  static std::size_t segment_of(std::size_t index) {
+    std::size_t n = index / FirstSegment + 1, k = 0;
+    while (n >>= 1)
+      ++k;
+    return k;
+  }
+
+  // Returns segment `k`, allocating it if needed. When several threads race
+  // to allocate the same segment, one of them wins and the others free theirs.
+  slot* segment(std::size_t k) {
+    slot* segment = segments_[k].load(std::memory_order_acquire);
+    if (segment != nullptr)
+      return segment;
+
+    std::size_t const size = segment_size(k);
+    slot* fresh = static_cast<slot*>(::operator new(size * sizeof(slot)));
+    for (std::size_t i = 0; i != size; ++i)
+      new (&fresh[i].published) std::atomic<bool>{false};
+    if (segments_[k].compare_exchange_strong(segment, fresh,
+                                             std::memory_order_acq_rel))
+      return fresh;
+    ::operator delete(fresh);
+    return segment;
+  }
+
+  std::atomic<slot*> segments_[max_segments];
+  std::atomic<std::size_t> reserved_{0};
+};
+
+#endif // header guard
@@ -0,0 +1,545 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// This example requires C++20 for coroutines. Since `dyno::requires` is a
+// keyword in C++20, the storage policies below are hand-rolled versions of
+// `dyno::local_storage`, `dyno::sbo_storage` and `dyno::remote_storage`.
+
+#include "allocations.hpp"
+
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Storage policies
+//////////////////////////////////////////////////////////////////////////////
+// sample(storage)
+template <std::size_t Size>
+struct local_storage {
+  template <typename T, typename ...Args>
+  void* construct(Args&& ...args) {
+    static_assert(sizeof(T) <= Size,
+      "can't hold such a large object in a local_storage");
+    return new (&buffer_) T(std::forward<Args>(args)...);
+  }
+
+  template <typename VTable>
+  void move_from(local_storage& other, VTable const& vtbl)
+  { vtbl.move(&buffer_, &other.buffer_); }
+
+  template <typename VTable>
+  void destruct(VTable const& vtbl)
+  { vtbl.dtor(&buffer_); }
+
+  void* get() { return &buffer_; }
+
+private:
+  std::aligned_storage_t<Size> buffer_;
+};
+
+template <std::size_t Size>
+struct sbo_storage {
+  template <typename T, typename ...Args>
+  void* construct(Args&& ...args) {
+    if (sizeof(T) > Size) {
+      on_heap_ = true;
+      return ptr_ = new T(std::forward<Args>(args)...);
+    } else {
+      on_heap_ = false;
+      return new (&buffer_) T(std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename VTable>
+  void move_from(sbo_storage& other, VTable const& vtbl) {
+    on_heap_ = other.on_heap_;
+    if (on_heap_) {
+      ptr_ = std::exchange(other.ptr_, nullptr);
+    } else {
+      vtbl.move(&buffer_, &other.buffer_);
+    }
+  }
+
+  template <typename VTable>
+  void destruct(VTable const& vtbl) {
+    if (on_heap_) {
+      if (ptr_) vtbl.delete_(ptr_);
+    } else {
+      vtbl.dtor(&buffer_);
+    }
+  }
+
+  void* get() { return on_heap_ ? ptr_ : &buffer_; }
+
+private:
+  union { void* ptr_;
+          std::aligned_storage_t<Size> buffer_; };
+  bool on_heap_;
+};
+
+struct remote_storage {
+  template <typename T, typename ...Args>
+  void* construct(Args&& ...args)
+  { return ptr_ = new T(std::forward<Args>(args)...); }
+
+  template <typename VTable>
+  void move_from(remote_storage& other, VTable const&)
+  { ptr_ = std::exchange(other.ptr_, nullptr); }
+
+  template <typename VTable>
+  void destruct(VTable const& vtbl)
+  { if (ptr_) vtbl.delete_(ptr_); }
+
+  void* get() { return ptr_; }
+
+private:
+  void* ptr_;
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Type-erased awaitable
+//////////////////////////////////////////////////////////////////////////////
+// sample(awaitable_vtable)
+template <typename R>
+struct awaitable_vtable {
+  bool (*await_ready)(void* this_);
+  std::coroutine_handle<> (*await_suspend)(void* this_,
+                                           std::coroutine_handle<> h);
+  R (*await_resume)(void* this_);
+  void (*move)(void* p, void* other);                 // skip-sample
+  void (*dtor)(void* p);                              // skip-sample
+  void (*delete_)(void* p);                           // skip-sample
+};
+
+// `await_suspend` may return `void`, `bool` or a coroutine handle; we
+// normalize all of them to a handle so the vtable has a single signature.
+template <typename T>
+std::coroutine_handle<> suspend_to_handle(T& awaiter,
+                                          std::coroutine_handle<> h) {
+  using Result = decltype(awaiter.await_suspend(h));
+  if constexpr (std::is_void_v<Result>) {
+    awaiter.await_suspend(h);
+    return std::noop_coroutine();
+  } else if constexpr (std::is_same_v<Result, bool>) {
+    return awaiter.await_suspend(h) ? std::noop_coroutine() : h;
+  } else {
+    return awaiter.await_suspend(h);
+  }
+}
+
+template <typename R, typename T>
+awaitable_vtable<R> const awaitable_vtable_for = {
+  [](void* this_) -> bool {
+    return static_cast<T*>(this_)->await_ready();
+  },
+  [](void* this_, std::coroutine_handle<> h) {
+    return suspend_to_handle(*static_cast<T*>(this_), h);
+  },
+  [](void* this_) -> R {
+    return static_cast<T*>(this_)->await_resume();
+  }
+  ,                                                   // skip-sample
+  [](void* p, void* other) {                          // skip-sample
+    new (p) T(std::move(*static_cast<T*>(other)));    // skip-sample
+  },                                                  // skip-sample
+  [](void* p) { static_cast<T*>(p)->~T(); },          // skip-sample
+  [](void* p) { delete static_cast<T*>(p); }          // skip-sample
+};
+// end-sample
+
+// sample(basic_any_awaitable)
+template <typename R, typename StoragePolicy>
+struct basic_any_awaitable {
+  template <typename Awaiter, typename = std::enable_if_t<
+    !std::is_same_v<std::decay_t<Awaiter>, basic_any_awaitable>
+  >>
+  basic_any_awaitable(Awaiter&& awaiter)
+    : vptr_{&awaitable_vtable_for<R, std::decay_t<Awaiter>>}
+  { storage_.template construct<std::decay_t<Awaiter>>(
+      std::forward<Awaiter>(awaiter)); }
+
+  basic_any_awaitable(basic_any_awaitable&& other) : vptr_{other.vptr_}
+  { storage_.move_from(other.storage_, *vptr_); }
+
+  bool await_ready()
+  { return vptr_->await_ready(storage_.get()); }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> h)
+  { return vptr_->await_suspend(storage_.get(), h); }
+
+  R await_resume()
+  { return vptr_->await_resume(storage_.get()); }
+
+  ~basic_any_awaitable()
+  { storage_.destruct(*vptr_); }
+
+private:
+  awaitable_vtable<R> const* vptr_;
+  StoragePolicy storage_;
+};
+// end-sample
+
+// sample(any_awaitable)
+template <typename R>
+using any_awaitable = basic_any_awaitable<R, sbo_storage<32>>;
+
+template <typename R, std::size_t Size = 64>
+using inplace_awaitable = basic_any_awaitable<R, local_storage<Size>>;
+
+template <typename R>
+using remote_awaitable = basic_any_awaitable<R, remote_storage>;
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Coroutine frame allocation
+//////////////////////////////////////////////////////////////////////////////
+// A `frame_buffer` is a caller-supplied chunk of memory in which a single
+// coroutine frame can live. To put the frame of a coroutine in it, pass the
+// buffer as the first argument of the coroutine.
+// sample(frame_buffer)
+template <std::size_t Size>
+struct frame_buffer {
+  void* try_acquire(std::size_t n) {
+    if (n > Size || in_use_) return nullptr;
+    in_use_ = true;
+    return &buffer_;
+  }
+
+  void release() { in_use_ = false; }
+  bool in_use() const { return in_use_; }
+
+private:
+  std::aligned_storage_t<Size, alignof(std::max_align_t)> buffer_;
+  bool in_use_ = false;
+};
+// end-sample
+
+// The frame allocator decides where a coroutine frame goes based on the same
+// storage policies as the erased awaitables above. Frames are only known in
+// size at runtime, so `local_storage` terminates instead of failing to compile
+// when the frame does not fit.
+//
+// Each frame is followed by a pointer to the buffer it lives in (or null when
+// it lives on the heap), since `operator delete` does not receive the
+// coroutine's arguments.
+namespace frame_detail {
+  struct trailer {
+    void* buffer;
+    void (*release)(void* buffer);
+  };
+
+  constexpr std::size_t trailer_offset(std::size_t n) {
+    return (n + alignof(trailer) - 1) & ~(alignof(trailer) - 1);
+  }
+
+  constexpr std::size_t total_size(std::size_t n)
+  { return trailer_offset(n) + sizeof(trailer); }
+
+  template <std::size_t Size>
+  void release(void* buffer)
+  { static_cast<frame_buffer<Size>*>(buffer)->release(); }
+
+  inline void* finish(void* frame, std::size_t n, trailer t) {
+    new (static_cast<char*>(frame) + trailer_offset(n)) trailer{t};
+    return frame;
+  }
+
+  inline void deallocate(void* frame, std::size_t n) {
+    auto* t = reinterpret_cast<trailer*>(static_cast<char*>(frame) +
+                                         trailer_offset(n));
+    if (t->buffer) {
+      t->release(t->buffer);
+    } else {
+      ::operator delete(frame);
+    }
+  }
+} // end namespace frame_detail
+
+template <typename StoragePolicy>
+struct frame_allocator;
+
+template <>
+struct frame_allocator<remote_storage> {
+  static void* allocate(std::size_t n) {
+    void* frame = ::operator new(frame_detail::total_size(n));
+    return frame_detail::finish(frame, n, {nullptr, nullptr});
+  }
+
+  static void deallocate(void* frame, std::size_t n)
+  { frame_detail::deallocate(frame, n); }
+};
+
+template <std::size_t Size>
+struct frame_allocator<sbo_storage<Size>> {
+  static void* allocate(std::size_t n, frame_buffer<Size>& buffer) {
+    if (void* frame = buffer.try_acquire(frame_detail::total_size(n)))
+      return frame_detail::finish(frame, n, {&buffer,
+                                             &frame_detail::release<Size>});
+    return frame_allocator<remote_storage>::allocate(n);
+  }
+
+  static void deallocate(void* frame, std::size_t n)
+  { frame_detail::deallocate(frame, n); }
+};
+
+template <std::size_t Size>
+struct frame_allocator<local_storage<Size>> {
+  static void* allocate(std::size_t n, frame_buffer<Size>& buffer) {
+    void* frame = buffer.try_acquire(frame_detail::total_size(n));
+    if (!frame)
+      std::terminate(); // frame doesn't fit in the buffer, or buffer is busy
+    return frame_detail::finish(frame, n, {&buffer,
+                                           &frame_detail::release<Size>});
+  }
+
+  static void deallocate(void* frame, std::size_t n)
+  { frame_detail::deallocate(frame, n); }
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+// task<T>
+//////////////////////////////////////////////////////////////////////////////
+template <typename T>
+struct task_result {
+  void return_value(T value) { value_.emplace(std::move(value)); }
+  T get() { return std::move(*value_); }
+private:
+  struct holder {
+    void emplace(T v) { new (&storage_) T(std::move(v)); engaged_ = true; }
+    T& operator*() { return *reinterpret_cast<T*>(&storage_); }
+    ~holder() { if (engaged_) (**this).~T(); }
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage_;
+    bool engaged_ = false;
+  } value_;
+};
+
+template <>
+struct task_result<void> {
+  void return_void() { }
+  void get() { }
+};
+
+// sample(task)
+template <typename T, typename FrameStorage = remote_storage>
+struct task {
+  struct promise_type : task_result<T> {
+    using Allocator = frame_allocator<FrameStorage>;
+
+    // Frames using `remote_storage` go on the heap.
+    template <typename ...Args>
+    static void* operator new(std::size_t n, Args const& ...)
+    { return Allocator::allocate(n); }
+
+    // Frames using `local_storage` or `sbo_storage` go in the caller-supplied
+    // buffer, which must be the first argument of the coroutine.
+    template <std::size_t Size, typename ...Args>
+    static void* operator new(std::size_t n, frame_buffer<Size>& buffer,
+                              Args const& ...)
+    { return Allocator::allocate(n, buffer); }
+
+    static void operator delete(void* frame, std::size_t n)
+    { Allocator::deallocate(frame, n); }
+
+    task get_return_object()
+    { return task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    auto final_suspend() noexcept {
+      struct resume_continuation {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+          auto continuation = h.promise().continuation_;
+          return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept { }
+      };
+      return resume_continuation{};
+    }
+
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+  };
+
+  task(task&& other) : h_{std::exchange(other.h_, nullptr)} { }
+  ~task() { if (h_) h_.destroy(); }
+
+  bool await_ready() { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+    h_.promise().continuation_ = awaiting;
+    return h_;
+  }
+
+  T await_resume() {
+    if (h_.promise().exception_)
+      std::rethrow_exception(h_.promise().exception_);
+    return h_.promise().get();
+  }
+
+  // Starts the task without waiting for it; used from non-coroutine code.
+  void start() { h_.resume(); }
+  bool done() const { return h_.done(); }
+  T result() { return await_resume(); }
+
+private:
+  explicit task(std::coroutine_handle<promise_type> h) : h_{h} { }
+  std::coroutine_handle<promise_type> h_;
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+// A toy event loop and some awaiters, standing in for asynchronous I/O.
+//////////////////////////////////////////////////////////////////////////////
+struct event_loop {
+  void schedule(std::coroutine_handle<> h) { ready_.push_back(h); }
+
+  void run() {
+    while (!ready_.empty()) {
+      auto h = ready_.front();
+      ready_.pop_front();
+      h.resume();
+    }
+  }
+
+private:
+  std::deque<std::coroutine_handle<>> ready_;
+};
+
+// Suspends and gets resumed later by the event loop, like a socket read.
+struct read_request {
+  event_loop* loop;
+  std::string payload;
+  bool await_ready() { return false; }
+  void await_suspend(std::coroutine_handle<> h) { loop->schedule(h); }
+  std::string await_resume() { return std::move(payload); }
+};
+
+// Completes synchronously, like a read that hits a buffer.
+struct buffered_read {
+  std::string payload;
+  bool await_ready() { return true; }
+  bool await_suspend(std::coroutine_handle<>) { return false; }
+  std::string await_resume() { return std::move(payload); }
+};
+
+// Large enough to spill out of the `any_awaitable` small buffer.
+struct large_read {
+  event_loop* loop;
+  char padding[128];
+  std::string payload;
+  bool await_ready() { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> h)
+  { loop->schedule(h); return std::noop_coroutine(); }
+  std::string await_resume() { return std::move(payload); }
+};
+
+template <typename Awaitable>
+Awaitable make_read(event_loop& loop, int i, std::string payload) {
+  switch (i % 3) {
+    case 0: return read_request{&loop, std::move(payload)};
+    case 1: return buffered_read{std::move(payload)};
+    default: return large_read{&loop, {}, std::move(payload)};
+  }
+}
+
+template <typename Awaitable>
+task<std::size_t> handle_request(event_loop& loop, int i) {
+  Awaitable read = make_read<Awaitable>(loop, i, std::to_string(i * 1000));
+  std::string payload = co_await std::move(read);
+  co_return payload.size();
+}
+
+template <std::size_t Size>
+task<std::size_t, sbo_storage<Size>>
+handle_request_sbo(frame_buffer<Size>&, event_loop& loop, int i) {
+  any_awaitable<std::string> read = make_read<any_awaitable<std::string>>(
+    loop, i, std::string(i, 'x'));
+  std::string payload = co_await std::move(read);
+  co_return payload.size();
+}
+
+template <std::size_t Size>
+task<std::size_t, local_storage<Size>>
+handle_request_local(frame_buffer<Size>&, event_loop& loop, int i) {
+  inplace_awaitable<std::string, 256> read =
+    make_read<inplace_awaitable<std::string, 256>>(loop, i, std::to_string(i));
+  std::string payload = co_await std::move(read);
+  co_return payload.size() + 1;
+}
+
+template <typename T, typename Storage>
+T run(event_loop& loop, task<T, Storage>& t) {
+  t.start();
+  loop.run();
+  assert(t.done());
+  return t.result();
+}
+
+template <typename Awaitable>
+void test() {
+  event_loop loop;
+  for (int i = 0; i != 9; ++i) {
+    auto t = handle_request<Awaitable>(loop, i);
+    assert(run(loop, t) == std::to_string(i * 1000).size());
+  }
+}
+
+int main() {
+  test<any_awaitable<std::string>>();
+  test<inplace_awaitable<std::string, 256>>();
+  test<remote_awaitable<std::string>>();
+
+  // Frames live in the caller-supplied buffer when they fit.
+  {
+    event_loop loop;
+    frame_buffer<1024> buffer;
+    for (int i = 0; i != 9; ++i) {
+      auto t = handle_request_sbo(buffer, loop, i);
+      assert(buffer.in_use());
+      assert(run(loop, t) == std::size_t(i));
+    }
+    assert(!buffer.in_use());
+  }
+
+  // Frames that don't fit spill to the heap with `sbo_storage`.
+  {
+    event_loop loop;
+    frame_buffer<8> buffer;
+    auto t = handle_request_sbo(buffer, loop, 4);
+    assert(!buffer.in_use());
+    assert(run(loop, t) == 4);
+  }
+
+  // Frames with `local_storage` never touch the heap, and neither do the
+  // awaitables they hold.
+  {
+    event_loop loop;
+    frame_buffer<1024> buffer;
+    allocation_counter counter;
+    for (int i = 0; i != 9; ++i) {
+      auto t = handle_request_local(buffer, loop, i);
+      assert(buffer.in_use());
+      assert(run(loop, t) == std::to_string(i).size() + 1);
+    }
+    assert(!buffer.in_use());
+    assert(counter.allocations() == 0);
+    assert(counter.deallocations() == 0);
+  }
+}
@@ -0,0 +1,184 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "vtable.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// sample(Vehicle)
+class Vehicle {
+  vtable const* vptr_;
+  void* ptr_;
+
+public:
+  template <typename Any>
+  Vehicle(Any vehicle)
+    : vptr_{&vtable_for<Any>}
+    , ptr_{new Any(vehicle)}
+  { }
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}
+    , ptr_{other.vptr_->clone(other.ptr_)}
+  { }
+
+  Vehicle& operator=(Vehicle other) {
+    std::swap(vptr_, other.vptr_);
+    std::swap(ptr_, other.ptr_);
+    return *this;
+  }
+
+  void accelerate()
+  { vptr_->accelerate(ptr_); }
+
+  // All the objects of the same type share the same vtable, so its address
+  // can be used to group objects by type.
+  vtable const* vptr() const { return vptr_; }
+
+  ~Vehicle()
+  { vptr_->delete_(ptr_); }
+};
+// end-sample
+
+// sample(dispatch_ordered_view)
+// A view over a `std::vector` of type-erased objects that visits them grouped
+// by dynamic type, so that consecutive calls go through the same vtable entry
+// and the indirect branches are easy to predict.
+//
+// The permutation is a bucket (counting) sort on a dense type ID computed
+// from the key returned by `key(element)`, typically the vtable pointer. It
+// is cached, and elements appended to the vector since the last traversal
+// are added to their bucket without re-sorting everything. If elements are
+// erased, reordered or assigned to, call `rebuild()`.
+template <typename T, typename Key>
+class dispatch_ordered_view {
+public:
+  dispatch_ordered_view(std::vector<T>& elements, Key key)
+    : elements_{elements}, key_{std::move(key)}
+  { }
+
+  // Calls `f` on every element, grouped by dynamic type. Within a group,
+  // elements are visited in their order in the underlying vector.
+  template <typename F>
+  void for_each(F f) {
+    update();
+    for (auto const& bucket : buckets_)
+      for (std::size_t index : bucket)
+        f(elements_[index]);
+  }
+
+  // Number of distinct dynamic types seen so far.
+  std::size_t types() {
+    update();
+    return buckets_.size();
+  }
+
+  void rebuild() {
+    buckets_.clear();
+    ids_.clear();
+    seen_ = 0;
+  }
+
+private:
+  void update() {
+    if (elements_.size() < seen_)
+      rebuild();
+    for (; seen_ != elements_.size(); ++seen_)
+      buckets_[id_of(key_(elements_[seen_]))].push_back(seen_);
+  }
+
+  std::size_t id_of(void const* key) {
+    auto it = ids_.find(key);
+    if (it != ids_.end())
+      return it->second;
+    buckets_.emplace_back();
+    return ids_[key] = buckets_.size() - 1;
+  }
+
+  std::vector<T>& elements_;
+  Key key_;
+  std::unordered_map<void const*, std::size_t> ids_;
+  std::vector<std::vector<std::size_t>> buckets_;
+  std::size_t seen_ = 0;
+};
+
+template <typename T, typename Key>
+dispatch_ordered_view<T, Key>
+dispatch_ordered(std::vector<T>& elements, Key key)
+{ return {elements, std::move(key)}; }
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> accelerated;
+
+struct Car {
+  std::string make;
+  int year;
+  void accelerate() { accelerated.push_back("Car " + make); }
+};
+
+struct Truck {
+  std::string make;
+  int year;
+  void accelerate() { accelerated.push_back("Truck " + make); }
+};
+
+struct Plane {
+  std::string make;
+  std::string model;
+  void accelerate() { accelerated.push_back("Plane " + make); }
+};
+
+// sample(main)
+int main() {
+  std::vector<Vehicle> vehicles;
+
+  vehicles.push_back(Car{"Audi", 2017});
+  vehicles.push_back(Truck{"Chevrolet", 2015});
+  vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.push_back(Car{"Toyota", 2012});
+  vehicles.push_back(Truck{"Ford", 2010});
+
+  auto by_type = dispatch_ordered(vehicles, [](Vehicle const& v) {
+    return static_cast<void const*>(v.vptr());
+  });
+
+  by_type.for_each([](Vehicle& vehicle) {
+    vehicle.accelerate();
+  });
+// end-sample
+
+  assert(by_type.types() == 3);
+  assert((accelerated == std::vector<std::string>{
+    "Car Audi", "Car Toyota", "Truck Chevrolet", "Truck Ford", "Plane Boeing"
+  }));
+
+  // Appending elements (even if the vector reallocates) keeps the cached
+  // permutation and only adds the new elements to it.
+  accelerated.clear();
+  vehicles.push_back(Plane{"Airbus", "A380"});
+  vehicles.push_back(Car{"Honda", 2018});
+  by_type.for_each([](Vehicle& vehicle) { vehicle.accelerate(); });
+  assert((accelerated == std::vector<std::string>{
+    "Car Audi", "Car Toyota", "Car Honda", "Truck Chevrolet", "Truck Ford",
+    "Plane Boeing", "Plane Airbus"
+  }));
+
+  // Shrinking the vector is detected, and the permutation is rebuilt.
+  accelerated.clear();
+  vehicles.erase(vehicles.begin());
+  by_type.for_each([](Vehicle& vehicle) { vehicle.accelerate(); });
+  assert((accelerated == std::vector<std::string>{
+    "Truck Chevrolet", "Truck Ford", "Plane Boeing", "Plane Airbus",
+    "Car Toyota", "Car Honda"
+  }));
+// sample(main)
+}
+// end-sample
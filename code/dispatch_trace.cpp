@@ -0,0 +1,123 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// The Vehicle below is always instrumented, like the benchmark vehicles are
+// when compiled with -DTRACE_DISPATCH.
+
+#include "dispatch_trace.hpp"
+#include "vtable.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+// sample(Vehicle)
+class Vehicle {
+  vtable const* const vptr_;
+  void* ptr_;
+  std::uint32_t type_;
+
+public:
+  template <typename Any>
+  Vehicle(Any vehicle)
+    : vptr_{&vtable_for<Any>}
+    , ptr_{new Any(vehicle)}
+    , type_{dispatch_type_id<Any>()}
+  { }
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}
+    , ptr_{other.vptr_->clone(other.ptr_)}
+    , type_{other.type_}
+  { }
+
+  void accelerate() {
+    trace_dispatch(type_, dispatch_method::accelerate, ptr_);
+    vptr_->accelerate(ptr_);
+  }
+
+  ~Vehicle()
+  { vptr_->delete_(ptr_); }
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+struct Car {
+  std::string make;
+  int year;
+  int speed = 0;
+  void accelerate() { speed += 1; }
+};
+
+struct Truck {
+  std::string make;
+  int year;
+  int speed = 0;
+  void accelerate() { speed += 2; }
+};
+
+// sample(main)
+int main() {
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(3); // skip-sample
+  vehicles.push_back(Car{"Audi", 2017});
+  vehicles.push_back(Truck{"Chevrolet", 2015});
+  vehicles.push_back(Car{"Toyota", 2012});
+
+  dispatch_trace trace{4};
+  trace.start();
+  for (auto& vehicle : vehicles) {
+    vehicle.accelerate();
+  }
+  vehicles[1].accelerate();
+  trace.stop();
+
+  trace.save("accelerate.trace");
+// end-sample
+
+  // Dispatches are recorded in order, with the type of the object and its
+  // address.
+  std::uint32_t const car = dispatch_type_id<Car>();
+  std::uint32_t const truck = dispatch_type_id<Truck>();
+  assert(car != truck);
+  std::vector<dispatch_record> records = trace.records();
+  assert(records.size() == 4);
+  assert(records[0].type == car && records[1].type == truck);
+  assert(records[2].type == car && records[3].type == truck);
+  assert(records[0].address != records[2].address);
+  assert(records[1].address == records[3].address);
+  for (auto const& record : records)
+    assert(record.method == static_cast<std::uint32_t>(dispatch_method::accelerate));
+
+  // Nothing is recorded once the trace is stopped.
+  vehicles[0].accelerate();
+  assert(trace.recorded() == 4);
+
+  // When the ring buffer is full, the oldest dispatches are dropped.
+  trace.start();
+  vehicles[0].accelerate();
+  vehicles[2].accelerate();
+  trace.stop();
+  assert(trace.recorded() == 6);
+  std::vector<dispatch_record> const latest = trace.records();
+  assert(latest.size() == 4);
+  assert(latest[0].address == records[2].address);
+  assert(latest[1].address == records[3].address);
+  assert(latest[2].address == records[0].address);
+  assert(latest[3].address == records[2].address);
+
+  // Traces saved to a file can be loaded back, e.g. by `benchmarks/replay.cpp`.
+  std::vector<dispatch_record> const loaded = dispatch_trace::load("accelerate.trace");
+  assert(loaded.size() == records.size());
+  for (std::size_t i = 0; i != loaded.size(); ++i) {
+    assert(loaded[i].type == records[i].type);
+    assert(loaded[i].address == records[i].address);
+  }
+  std::remove("accelerate.trace");
+// sample(main)
+}
+// end-sample
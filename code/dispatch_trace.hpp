@@ -0,0 +1,149 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef DISPATCH_TRACE_HPP
+#define DISPATCH_TRACE_HPP
+
+// Records the sequence of dynamic dispatches performed by a program, so that
+// the benchmarks can be replayed against a real call pattern instead of a
+// synthetic loop (see `benchmarks/replay.cpp`).
+//
+// Dispatches are only recorded when the code is compiled with
+// `-DTRACE_DISPATCH`, and only on threads where a `dispatch_trace` has been
+// started. Each dispatch is recorded as a (type ID, method ID, address)
+// triple in a fixed size ring buffer, so that tracing a long running program
+// keeps the most recent dispatches and never allocates.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+// The methods that can be traced.
+enum class dispatch_method : std::uint32_t {
+  accelerate = 0
+};
+
+struct dispatch_record {
+  std::uint32_t type;      // dense ID returned by `dispatch_type_id<T>()`
+  std::uint32_t method;    // a `dispatch_method`
+  std::uint64_t address;   // identifies the object the method was called on
+};
+static_assert(sizeof(dispatch_record) == 16, "");
+
+namespace dispatch_trace_detail {
+  inline std::uint32_t next_type_id() {
+    static std::atomic<std::uint32_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+} // end namespace dispatch_trace_detail
+
+// A small integer identifying `T`, assigned the first time it is requested.
+// IDs are only meaningful within a single run of a program.
+template <typename T>
+std::uint32_t dispatch_type_id() {
+  static std::uint32_t const id = dispatch_trace_detail::next_type_id();
+  return id;
+}
+
+class dispatch_trace {
+public:
+  // The capacity is rounded up to a power of 2.
+  explicit dispatch_trace(std::size_t capacity = std::size_t(1) << 20) {
+    std::size_t size = 1;
+    while (size < capacity)
+      size *= 2;
+    records_.resize(size);
+  }
+
+  dispatch_trace(dispatch_trace const&) = delete;
+  dispatch_trace& operator=(dispatch_trace const&) = delete;
+
+  ~dispatch_trace() { stop(); }
+
+  // Starts or stops recording the dispatches made by the calling thread.
+  void start() { active() = this; }
+  void stop() { if (active() == this) active() = nullptr; }
+
+  // The trace being recorded on the calling thread, if any.
+  static dispatch_trace*& active() {
+    thread_local dispatch_trace* trace = nullptr;
+    return trace;
+  }
+
+  void record(std::uint32_t type, dispatch_method method,
+              void const* address) {
+    records_[recorded_++ & (records_.size() - 1)] = {
+      type, static_cast<std::uint32_t>(method),
+      static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(address))
+    };
+  }
+
+  // Total number of dispatches recorded, including the ones that were
+  // overwritten because the ring buffer was full.
+  std::uint64_t recorded() const { return recorded_; }
+
+  // The dispatches still in the ring buffer, oldest first.
+  std::vector<dispatch_record> records() const {
+    std::size_t const capacity = records_.size();
+    if (recorded_ <= capacity)
+      return {records_.begin(), records_.begin() + recorded_};
+    std::size_t const oldest = recorded_ & (capacity - 1);
+    std::vector<dispatch_record> result(records_.begin() + oldest,
+                                        records_.end());
+    result.insert(result.end(), records_.begin(), records_.begin() + oldest);
+    return result;
+  }
+
+  // The file format is an 8 byte magic string, the number of records as a
+  // 64 bit integer and the records themselves, all in native byte order.
+  void save(std::string const& path) const {
+    std::vector<dispatch_record> const records = this->records();
+    std::uint64_t const count = records.size();
+    std::ofstream out{path, std::ios::binary};
+    out.write(magic(), magic_size);
+    out.write(reinterpret_cast<char const*>(&count), sizeof(count));
+    out.write(reinterpret_cast<char const*>(records.data()),
+              static_cast<std::streamsize>(count * sizeof(dispatch_record)));
+    if (!out)
+      throw std::runtime_error{"unable to write dispatch trace " + path};
+  }
+
+  static std::vector<dispatch_record> load(std::string const& path) {
+    std::ifstream in{path, std::ios::binary};
+    char header[magic_size];
+    std::uint64_t count = 0;
+    in.read(header, sizeof(header));
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || std::memcmp(header, magic(), magic_size) != 0)
+      throw std::runtime_error{"not a dispatch trace: " + path};
+    std::vector<dispatch_record> records(count);
+    in.read(reinterpret_cast<char*>(records.data()),
+            static_cast<std::streamsize>(count * sizeof(dispatch_record)));
+    if (!in)
+      throw std::runtime_error{"truncated dispatch trace: " + path};
+    return records;
+  }
+
+private:
+  static constexpr std::size_t magic_size = 8;
+  static char const* magic() { return "DISPTRC1"; }
+
+  std::vector<dispatch_record> records_;
+  std::uint64_t recorded_ = 0;
+};
+
+// Records a dispatch in the calling thread's trace. This is what the
+// instrumented `accelerate()` methods call when `TRACE_DISPATCH` is defined.
+inline void trace_dispatch(std::uint32_t type, dispatch_method method,
+                           void const* address) {
+  if (dispatch_trace* trace = dispatch_trace::active())
+    trace->record(type, method, address);
+}
+
+#endif // header guard
@@ -0,0 +1,143 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef FUNCTION_HPP
+#define FUNCTION_HPP
+
+#include "in_place.hpp"
+
+#include <dyno.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+using namespace dyno::literals;
+
+
+template <typename Signature>
+struct Callable;
+
+template <typename R, typename ...Args>
+struct Callable<R(Args...)> : decltype(dyno::requires(
+  dyno::CopyConstructible{},
+  dyno::MoveConstructible{},
+  dyno::Destructible{},
+  "call"_s = dyno::function<R (dyno::T const&, Args...)>
+)) { };
+
+template <typename R, typename ...Args, typename F>
+auto const dyno::default_concept_map<Callable<R(Args...)>, F> = dyno::make_concept_map(
+  "call"_s = [](F const& f, Args ...args) -> R {
+    return f(std::forward<Args>(args)...);
+  }
+);
+
+// Whether `F` models `Callable<Signature>` with the default concept map above,
+// for code that stores callables without erasing them one by one.
+template <typename Signature, typename F, typename = void>
+struct is_callable : std::false_type { };
+
+template <typename R, typename ...Args, typename F>
+struct is_callable<R(Args...), F, std::enable_if_t<
+  std::is_copy_constructible<F>::value &&
+  std::is_move_constructible<F>::value &&
+  std::is_destructible<F>::value &&
+  (std::is_void<R>::value || std::is_convertible<
+    decltype(std::declval<F const&>()(std::declval<Args>()...)), R>::value)
+>> : std::true_type { };
+
+// sample(basic_function)
+template <typename Signature, typename StoragePolicy>
+struct basic_function;
+
+template <typename R, typename ...Args, typename StoragePolicy>
+struct basic_function<R(Args...), StoragePolicy> {
+  template <typename F>
+  basic_function(F&& f) : poly_{std::forward<F>(f)} { }
+                                                                // skip-sample
+  // `dyno::poly` can't construct an object in place, so the `F` // skip-sample
+  // is constructed first and moved into the poly. Likewise,     // skip-sample
+  // `emplace` moves a new function into this one.               // skip-sample
+  template <typename F, typename ...CtorArgs>                   // skip-sample
+  basic_function(in_place_type_t<F>, CtorArgs&& ...args)        // skip-sample
+    : poly_{make_object<F>(std::forward<CtorArgs>(args)...)}    // skip-sample
+  { }                                                           // skip-sample
+                                                                // skip-sample
+  template <typename F, typename ...CtorArgs>                   // skip-sample
+  void emplace(CtorArgs&& ...args) {                            // skip-sample
+    *this = basic_function{in_place_type<F>,                    // skip-sample
+                           std::forward<CtorArgs>(args)...};    // skip-sample
+  }                                                             // skip-sample
+
+  R operator()(Args ...args) const
+  { return poly_.virtual_("call"_s)(poly_, args...); }
+
+private:
+  dyno::poly<Callable<R(Args...)>, StoragePolicy> poly_;
+};
+// end-sample
+
+// sample(function)
+template <typename Signature>
+using function = basic_function<Signature,
+                                dyno::sbo_storage<16>>;
+// end-sample
+
+// sample(function_view)
+template <typename Signature>
+using function_view = basic_function<Signature,
+                                     dyno::non_owning_storage>;
+// end-sample
+
+// sample(inplace_function)
+template <typename Signature, std::size_t Size = 32>
+using inplace_function = basic_function<Signature,
+                                        dyno::local_storage<Size>>;
+// end-sample
+
+// sample(shared_function)
+template <typename Signature>
+using shared_function = basic_function<Signature,
+                                       dyno::shared_remote_storage>;
+// end-sample
+
+// sample(composed)
+// Calling a pipeline of functions that were each erased costs an indirect
+// call per stage. Composing the stages while their types are still known
+// gives a single function object that is erased once, and through which
+// the compiler can inline every stage:
+//
+//  function<int(int)> pipeline = then(parse, validate).then(store);
+template <typename F, typename G>
+struct composed {
+  F f;
+  G g;
+
+  template <typename ...Args>
+  decltype(auto) operator()(Args&& ...args) const
+  { return g(f(std::forward<Args>(args)...)); }
+
+  template <typename H>
+  composed<composed, std::decay_t<H>> then(H&& h) const
+  { return {*this, std::forward<H>(h)}; }
+};
+
+// Returns a function object calling `f`, and then `g` with its result.
+template <typename F, typename G>
+composed<std::decay_t<F>, std::decay_t<G>> then(F&& f, G&& g)
+{ return {std::forward<F>(f), std::forward<G>(g)}; }
+// end-sample
+
+// Returns a function object calling the last function, and then each of the
+// others with the result of the next one, like `f(g(h(x)))`.
+template <typename F>
+std::decay_t<F> compose(F&& f)
+{ return std::forward<F>(f); }
+
+template <typename F, typename G, typename ...H>
+auto compose(F&& f, G&& g, H&& ...h) {
+  return then(compose(std::forward<G>(g), std::forward<H>(h)...),
+              std::forward<F>(f));
+}
+
+#endif // header guard
@@ -1,7 +1,8 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
-#include <dyno.hpp>
+#include "function.hpp"
+#include "in_place.hpp"
 
 #include <cassert>
 #include <functional>
@@ -10,66 +11,6 @@
 using namespace dyno::literals;
 
 
-template <typename Signature>
-struct Callable;
-
-template <typename R, typename ...Args>
-struct Callable<R(Args...)> : decltype(dyno::requires(
-  dyno::CopyConstructible{},
-  dyno::MoveConstructible{},
-  dyno::Destructible{},
-  "call"_s = dyno::function<R (dyno::T const&, Args...)>
-)) { };
-
-template <typename R, typename ...Args, typename F>
-auto const dyno::default_concept_map<Callable<R(Args...)>, F> = dyno::make_concept_map(
-  "call"_s = [](F const& f, Args ...args) -> R {
-    return f(std::forward<Args>(args)...);
-  }
-);
-
-// sample(basic_function)
-template <typename Signature, typename StoragePolicy>
-struct basic_function;
-
-template <typename R, typename ...Args, typename StoragePolicy>
-struct basic_function<R(Args...), StoragePolicy> {
-  template <typename F>
-  basic_function(F&& f) : poly_{std::forward<F>(f)} { }
-
-  R operator()(Args ...args) const
-  { return poly_.virtual_("call"_s)(poly_, args...); }
-
-private:
-  dyno::poly<Callable<R(Args...)>, StoragePolicy> poly_;
-};
-// end-sample
-
-// sample(function)
-template <typename Signature>
-using function = basic_function<Signature,
-                                dyno::sbo_storage<16>>;
-// end-sample
-
-// sample(function_view)
-template <typename Signature>
-using function_view = basic_function<Signature,
-                                     dyno::non_owning_storage>;
-// end-sample
-
-// sample(inplace_function)
-template <typename Signature, std::size_t Size = 32>
-using inplace_function = basic_function<Signature,
-                                        dyno::local_storage<Size>>;
-// end-sample
-
-// sample(shared_function)
-template <typename Signature>
-using shared_function = basic_function<Signature,
-                                       dyno::shared_remote_storage>;
-// end-sample
-
-
 //
 // Tests
 //
@@ -140,6 +81,39 @@ void test() {
   }
 }
 
+struct Multiply {
+  int factor;
+  int operator()(int i) const { return factor * i; }
+};
+
+// Constructing the callable directly in the function's storage.
+template <template <typename> class Function>
+void test_in_place() {
+  Function<int(int)> f{in_place_type<Multiply>, 3};
+  assert(f(1) == 3);
+  assert(f(2) == 6);
+
+  f.template emplace<Multiply>(5);
+  assert(f(1) == 5);
+  assert(f(2) == 10);
+}
+
+// Composing functions before erasing them.
+template <template <typename> class Function>
+void test_compose() {
+  auto add_one = [](int i) { return i + 1; };
+  auto twice = [](int i) { return 2 * i; };
+  auto to_string = [](int i) { return std::to_string(i); };
+
+  Function<std::string(int)> f = then(add_one, twice).then(to_string);
+  assert(f(1) == "4");
+  assert(f(20) == "42");
+
+  Function<int(int)> g = compose(add_one, twice, Multiply{3});
+  assert(g(1) == 7);
+  assert(compose(add_one)(1) == 2);
+}
+
 template <typename Signature>
 using my_inplace_function = inplace_function<Signature>;
 
@@ -148,4 +122,19 @@ int main() {
   test<function_view>();
   test<my_inplace_function>();
   test<shared_function>();
+
+  test_in_place<function>();
+  test_in_place<my_inplace_function>();
+  test_in_place<shared_function>();
+
+  test_compose<function>();
+  test_compose<my_inplace_function>();
+  test_compose<shared_function>();
+
+  // Erased functions can be stages too, but they aren't fused.
+  {
+    function<int(int)> const twice = [](int i) { return 2 * i; };
+    function<std::string(int)> f = then(twice, ToString{});
+    assert(f(21) == "42");
+  }
 }
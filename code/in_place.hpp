@@ -0,0 +1,103 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef IN_PLACE_HPP
+#define IN_PLACE_HPP
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// `std::in_place_type_t` is only available in C++17, so here's the same thing
+// for the examples. Passing `in_place_type<T>` to a Vehicle's constructor
+// constructs the `T` directly in the Vehicle's storage from the remaining
+// arguments, instead of copying a `T` that was constructed beforehand.
+template <typename T>
+struct in_place_type_t {
+  explicit in_place_type_t() = default;
+};
+
+template <typename T>
+constexpr in_place_type_t<T> in_place_type{};
+
+// Objects are constructed from the arguments with parentheses, like
+// `emplace` does. Aggregates can't be initialized with parentheses before
+// C++20, so they are initialized with braces instead.
+namespace in_place_detail {
+  template <typename T, typename ...Args>
+  using parens = std::is_constructible<T, Args...>;
+
+  template <typename T, typename ...Args>
+  T* construct_object(std::true_type, void* where, Args&& ...args)
+  { return ::new (where) T(std::forward<Args>(args)...); }
+
+  template <typename T, typename ...Args>
+  T* construct_object(std::false_type, void* where, Args&& ...args)
+  { return ::new (where) T{std::forward<Args>(args)...}; }
+
+  template <typename T, typename ...Args>
+  T* new_object(std::true_type, Args&& ...args)
+  { return new T(std::forward<Args>(args)...); }
+
+  template <typename T, typename ...Args>
+  T* new_object(std::false_type, Args&& ...args)
+  { return new T{std::forward<Args>(args)...}; }
+
+  template <typename T, typename ...Args>
+  T make_object(std::true_type, Args&& ...args)
+  { return T(std::forward<Args>(args)...); }
+
+  template <typename T, typename ...Args>
+  T make_object(std::false_type, Args&& ...args)
+  { return T{std::forward<Args>(args)...}; }
+} // end namespace in_place_detail
+
+// Constructs a `T` at `where`.
+template <typename T, typename ...Args>
+T* construct_object(void* where, Args&& ...args) {
+  return in_place_detail::construct_object<T>(
+    in_place_detail::parens<T, Args...>{}, where, std::forward<Args>(args)...);
+}
+
+// Constructs a `T` on the heap, to be released with `delete`.
+template <typename T, typename ...Args>
+T* new_object(Args&& ...args) {
+  return in_place_detail::new_object<T>(
+    in_place_detail::parens<T, Args...>{}, std::forward<Args>(args)...);
+}
+
+// Returns a `T`, for interfaces that can only take an object to move from.
+template <typename T, typename ...Args>
+T make_object(Args&& ...args) {
+  return in_place_detail::make_object<T>(
+    in_place_detail::parens<T, Args...>{}, std::forward<Args>(args)...);
+}
+
+namespace in_place_detail {
+  // Makes `std::allocate_shared` construct the object with `construct_object`.
+  template <typename T>
+  struct allocator : std::allocator<T> {
+    template <typename U>
+    struct rebind { using other = allocator<U>; };
+
+    allocator() = default;
+    template <typename U>
+    allocator(allocator<U> const&) { }
+
+    template <typename U, typename ...Args>
+    void construct(U* where, Args&& ...args)
+    { ::construct_object<U>(where, std::forward<Args>(args)...); }
+  };
+} // end namespace in_place_detail
+
+// Constructs a `T` in the same allocation as its reference count, like
+// `std::make_shared` does.
+template <typename T, typename ...Args>
+std::shared_ptr<T> make_shared_object(Args&& ...args) {
+  return std::allocate_shared<T>(in_place_detail::allocator<T>{},
+                                 std::forward<Args>(args)...);
+}
+
+#endif // header guard
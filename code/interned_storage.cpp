@@ -0,0 +1,303 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// Interned objects are shared and hence immutable, so only `const` methods
+// can be dispatched to. On top of that, the vtable knows how to hash and
+// compare objects, so that equal objects can be found in the intern table.
+// sample(interned_vtable)
+struct interned_vtable {
+  void (*accelerate)(void const* this_);
+  void (*dtor)(void* this_);
+  std::size_t (*hash)(void const* this_);
+  bool (*equal)(void const* this_, void const* other);
+};
+
+template <typename T>
+interned_vtable const interned_vtable_for = {
+  [](void const* this_) {
+    static_cast<T const*>(this_)->accelerate();
+  },
+
+  [](void* this_) {
+    static_cast<T*>(this_)->~T();
+  },
+
+  [](void const* this_) -> std::size_t {
+    return hash_value(*static_cast<T const*>(this_));
+  },
+
+  [](void const* this_, void const* other) -> bool {
+    return *static_cast<T const*>(this_) == *static_cast<T const*>(other);
+  }
+};
+// end-sample
+
+// sample(intern_table)
+// A table of unique, reference counted objects of any type. The table is
+// split in shards that are locked independently, so that threads interning
+// unrelated objects rarely contend.
+class intern_table {
+public:
+  struct node {
+    interned_vtable const* vptr;
+    std::size_t hash;
+    std::atomic<std::size_t> refs;
+  };
+// end-sample
+
+  // The object lives right after its node.
+  static constexpr std::size_t header_size =
+    (sizeof(node) + alignof(std::max_align_t) - 1)
+      & ~(alignof(std::max_align_t) - 1);
+
+  static void* object(node* n)
+  { return reinterpret_cast<char*>(n) + header_size; }
+
+  // Returns the node holding an object equal to `value`, creating it if
+  // there is none, with one more reference.
+  template <typename T>
+  node* intern(T const& value) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+      "over-aligned types are not supported");
+    interned_vtable const* vptr = &interned_vtable_for<T>;
+    std::size_t const hash = vptr->hash(&value);
+    shard& s = shard_for(hash);
+    std::lock_guard<std::mutex> lock{s.mutex};
+
+    auto range = s.nodes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      node* n = it->second;
+      if (n->vptr == vptr && vptr->equal(object(n), &value)) {
+        // Can't be 0, since dropping the last reference takes the lock.
+        n->refs.fetch_add(1, std::memory_order_relaxed);
+        return n;
+      }
+    }
+
+    void* memory = std::malloc(header_size + sizeof(T));
+    if (memory == nullptr)
+      throw std::bad_alloc{};
+    node* n = new (memory) node{vptr, hash, {1}};
+    try {
+      new (object(n)) T(value);
+    } catch (...) {
+      std::free(memory);
+      throw;
+    }
+    try {
+      s.nodes.emplace(hash, n);
+    } catch (...) {
+      vptr->dtor(object(n));
+      std::free(memory);
+      throw;
+    }
+    return n;
+  }
+
+  static void retain(node* n)
+  { n->refs.fetch_add(1, std::memory_order_relaxed); }
+
+  // Drops a reference, removing the object from the table and destroying it
+  // when it was the last one.
+  void release(node* n) {
+    // Fast path: this is not the last reference, so there's no need to lock.
+    std::size_t refs = n->refs.load(std::memory_order_relaxed);
+    while (refs > 1) {
+      if (n->refs.compare_exchange_weak(refs, refs - 1,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed))
+        return;
+    }
+
+    // Going from 1 to 0 must happen under the lock, otherwise `intern()`
+    // could hand out the object while it is being destroyed.
+    shard& s = shard_for(n->hash);
+    {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      if (n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+      auto range = s.nodes.equal_range(n->hash);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == n) {
+          s.nodes.erase(it);
+          break;
+        }
+      }
+    }
+    n->vptr->dtor(object(n));
+    n->~node();
+    std::free(n);
+  }
+
+  // Number of distinct objects in the table.
+  std::size_t size() {
+    std::size_t total = 0;
+    for (shard& s : shards_) {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      total += s.nodes.size();
+    }
+    return total;
+  }
+
+private:
+  struct shard {
+    std::mutex mutex;
+    std::unordered_multimap<std::size_t, node*> nodes;
+  };
+
+  shard& shard_for(std::size_t hash)
+  { return shards_[(hash ^ (hash >> 16)) % shards_.size()]; }
+
+  std::array<shard, 16> shards_;
+};
+
+intern_table& interned_objects() {
+  static intern_table table;
+  return table;
+}
+
+// sample(Vehicle)
+class Vehicle {
+  intern_table::node* node_; // the only member: copies are pointer-sized
+
+public:
+  template <typename Any>
+  Vehicle(Any const& vehicle)
+    : node_{interned_objects().intern(vehicle)}
+  { }
+
+  Vehicle(Vehicle const& other) : node_{other.node_}
+  { intern_table::retain(node_); }
+
+  Vehicle& operator=(Vehicle const& other) {
+    intern_table::retain(other.node_);
+    interned_objects().release(node_);
+    node_ = other.node_;
+    return *this;
+  }
+
+  ~Vehicle()
+  { interned_objects().release(node_); }
+
+  void accelerate() const
+  { node_->vptr->accelerate(intern_table::object(node_)); }
+
+  // Equal objects are interned only once, so comparing them is cheap.
+  friend bool operator==(Vehicle const& a, Vehicle const& b)
+  { return a.node_ == b.node_; }
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+std::atomic<int> accelerated{0};
+
+struct Car {
+  std::string make;
+  std::string model;
+  int year;
+  void accelerate() const { ++accelerated; }
+
+  friend bool operator==(Car const& a, Car const& b)
+  { return a.make == b.make && a.model == b.model && a.year == b.year; }
+
+  friend std::size_t hash_value(Car const& c) {
+    return std::hash<std::string>{}(c.make) * 31 +
+           std::hash<std::string>{}(c.model) * 17 + std::size_t(c.year);
+  }
+};
+
+struct Truck {
+  std::string make;
+  int year;
+  void accelerate() const { ++accelerated; }
+
+  friend bool operator==(Truck const& a, Truck const& b)
+  { return a.make == b.make && a.year == b.year; }
+
+  friend std::size_t hash_value(Truck const& t)
+  { return std::hash<std::string>{}(t.make) * 31 + std::size_t(t.year); }
+};
+
+// sample(main)
+int main() {
+  std::vector<Vehicle> fleet;
+
+  for (int i = 0; i != 1000; ++i) {
+    fleet.push_back(Car{"Toyota", "Corolla", 2012});
+    fleet.push_back(Car{"Audi", "A4", 2017});
+    fleet.push_back(Truck{"Chevrolet", 2015});
+  }
+
+  // 3000 vehicles, but only 3 objects in memory.
+  assert(interned_objects().size() == 3);
+  static_assert(sizeof(Vehicle) == sizeof(void*), "");
+
+  for (auto const& vehicle : fleet) {
+    vehicle.accelerate();
+  }
+// end-sample
+
+  assert(accelerated == 3000);
+  assert(fleet[0] == fleet[3]);
+  assert(!(fleet[0] == fleet[1]));
+
+  // Objects of different types are never equal, even with equal members.
+  {
+    Vehicle truck = Truck{"Toyota", 2012};
+    Vehicle car = Car{"Toyota", "", 2012};
+    assert(!(truck == car));
+    assert(interned_objects().size() == 5);
+    assert(!(truck == fleet[0]));
+  }
+  assert(interned_objects().size() == 3);
+
+  // Objects are removed from the table along with their last reference.
+  fleet.erase(fleet.begin() + 2, fleet.end());
+  assert(interned_objects().size() == 2);
+  fleet.clear();
+  assert(interned_objects().size() == 0);
+
+  // Threads interning the same values concurrently end up sharing them.
+  std::vector<std::thread> threads;
+  std::vector<std::vector<Vehicle>> fleets(8);
+  for (auto& f : fleets) {
+    threads.emplace_back([&f] {
+      for (int i = 0; i != 1000; ++i) {
+        f.push_back(Car{"Honda", "Civic", 2000 + i % 10});
+        f.push_back(Truck{"Ford", 2010});
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  assert(interned_objects().size() == 11);
+  for (auto const& f : fleets)
+    assert(f[0] == fleets[0][0]);
+
+  // And release them concurrently too.
+  threads.clear();
+  for (auto& f : fleets)
+    threads.emplace_back([&f] { f.clear(); });
+  for (auto& thread : threads)
+    thread.join();
+  assert(interned_objects().size() == 0);
+// sample(main)
+}
+// end-sample
@@ -1,10 +1,14 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
+#include "in_place.hpp"
+#include "prefetch.hpp"
+
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -30,7 +34,7 @@ vtable const vtable_for = {
 
 // sample(joined_vtable)
 struct joined_vtable {
-  vtable const* const remote;
+  vtable const* remote;
   void (*accelerate)(void* this_);
 };
 
@@ -45,7 +49,7 @@ joined_vtable const joined_vtable_for = {
 
 // sample(Vehicle)
 class Vehicle {
-  joined_vtable const vtbl_;
+  joined_vtable vtbl_;
   void* ptr_;
 
 public:
@@ -54,14 +58,34 @@ public:
     : vtbl_{joined_vtable_for<Any>}
     , ptr_{new Any(vehicle)}
   { }
-                                                      // skip-sample
-  Vehicle(Vehicle const& other)                       // skip-sample
-    : vtbl_{other.vtbl_}                              // skip-sample
-    , ptr_{other.vtbl_.remote->clone(other.ptr_)}     // skip-sample
-  { }                                                 // skip-sample
+                                                                        // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  Vehicle(in_place_type_t<Any>, Args&& ...args)                         // skip-sample
+    : vtbl_{joined_vtable_for<Any>}                                     // skip-sample
+    , ptr_{new_object<Any>(std::forward<Args>(args)...)}                // skip-sample
+  { }                                                                   // skip-sample
+                                                                        // skip-sample
+  Vehicle(Vehicle const& other)                                         // skip-sample
+    : vtbl_{other.vtbl_}                                                // skip-sample
+    , ptr_{other.vtbl_.remote->clone(other.ptr_)}                       // skip-sample
+  { }                                                                   // skip-sample
+                                                                        // skip-sample
+  // Replaces the vehicle by an `Any` constructed in its final storage. // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  void emplace(Args&& ...args) {                                        // skip-sample
+    void* ptr = new_object<Any>(std::forward<Args>(args)...);           // skip-sample
+    vtbl_.remote->delete_(ptr_);                                        // skip-sample
+    vtbl_ = joined_vtable_for<Any>;                                     // skip-sample
+    ptr_ = ptr;                                                         // skip-sample
+  }                                                                     // skip-sample
+                                                                        // skip-sample
+  Vehicle& operator=(Vehicle const&) = delete;                          // skip-sample
 
   void accelerate()
   { vtbl_.accelerate(ptr_); }
+                                                      // skip-sample
+  void prefetch() const                               // skip-sample
+  { ::prefetch(ptr_); }                               // skip-sample
 
   ~Vehicle()
   { vtbl_.remote->delete_(ptr_); }
@@ -95,6 +119,8 @@ int main() {
   vehicles.push_back(Car{"Audi", 2017});
   vehicles.push_back(Truck{"Chevrolet", 2015});
   vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.emplace_back(in_place_type<Car>, "Toyota", 2012); // skip-sample
+  vehicles.back().emplace<Plane>("Airbus", "A380");          // skip-sample
 
   for (auto& vehicle : vehicles) {
     vehicle.accelerate();
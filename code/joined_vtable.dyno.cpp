@@ -1,6 +1,7 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
+#include "in_place.hpp"
 #include "vtable.dyno.hpp"
 
 #include <dyno.hpp>
@@ -8,6 +9,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace dyno::literals;
 
@@ -16,6 +18,16 @@ using namespace dyno::literals;
 struct Vehicle {
   template <typename Any>
   Vehicle(Any vehicle) : poly_{vehicle} { }
+                                                                              // skip-sample
+  template <typename Any, typename ...Args>                                   // skip-sample
+  Vehicle(in_place_type_t<Any>, Args&& ...args)                               // skip-sample
+    : poly_{make_object<Any>(std::forward<Args>(args)...)}                    // skip-sample
+  { }                                                                         // skip-sample
+                                                                              // skip-sample
+  // `dyno::poly` can't construct in place, so the new vehicle is moved in.   // skip-sample
+  template <typename Any, typename ...Args>                                   // skip-sample
+  void emplace(Args&& ...args)                                                // skip-sample
+  { poly_ = decltype(poly_){make_object<Any>(std::forward<Args>(args)...)}; } // skip-sample
 
   void accelerate()
   { poly_.virtual_("accelerate"_s)(poly_); }
@@ -56,6 +68,8 @@ int main() {
   vehicles.push_back(Car{"Audi", 2017});
   vehicles.push_back(Truck{"Chevrolet", 2015});
   vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.emplace_back(in_place_type<Car>, "Toyota", 2012); // skip-sample
+  vehicles.back().emplace<Plane>("Airbus", "A380");          // skip-sample
 
   for (auto& vehicle : vehicles) {
     vehicle.accelerate();
@@ -1,17 +1,19 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
+#include "in_place.hpp"
 #include "vtable.hpp"
 
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 
 // sample(Vehicle)
 class Vehicle {
-  vtable const* const vptr_;
+  vtable const* vptr_;
   std::aligned_storage_t<64> buffer_;
 
 public:
@@ -21,10 +23,33 @@ public:
       "can't hold such a large object in a Vehicle");
     new (&buffer_) Any(vehicle);
   }
-                                                        // skip-sample
-  Vehicle(Vehicle const& other) : vptr_{other.vptr_} {  // skip-sample
-    other.vptr_->copy(&buffer_, &other.buffer_);        // skip-sample
-  }                                                     // skip-sample
+                                                                            // skip-sample
+  template <typename Any, typename ...Args>                                 // skip-sample
+  Vehicle(in_place_type_t<Any>, Args&& ...args)                             // skip-sample
+    : vptr_{&vtable_for<Any>}                                               // skip-sample
+  {                                                                         // skip-sample
+    static_assert(sizeof(Any) <= sizeof(buffer_),                           // skip-sample
+      "can't hold such a large object in a Vehicle");                       // skip-sample
+    construct_object<Any>(&buffer_, std::forward<Args>(args)...);           // skip-sample
+  }                                                                         // skip-sample
+                                                                            // skip-sample
+  Vehicle(Vehicle const& other) : vptr_{other.vptr_} {                      // skip-sample
+    other.vptr_->copy(&buffer_, &other.buffer_);                            // skip-sample
+  }                                                                         // skip-sample
+                                                                            // skip-sample
+  // Replaces the vehicle by an `Any` constructed in the buffer. The old    // skip-sample
+  // vehicle must be destroyed first, so a throwing constructor would leave // skip-sample
+  // nothing to destroy; `noexcept` makes that terminate instead.           // skip-sample
+  template <typename Any, typename ...Args>                                 // skip-sample
+  void emplace(Args&& ...args) noexcept {                                   // skip-sample
+    static_assert(sizeof(Any) <= sizeof(buffer_),                           // skip-sample
+      "can't hold such a large object in a Vehicle");                       // skip-sample
+    vptr_->dtor(&buffer_);                                                  // skip-sample
+    vptr_ = &vtable_for<Any>;                                               // skip-sample
+    construct_object<Any>(&buffer_, std::forward<Args>(args)...);           // skip-sample
+  }                                                                         // skip-sample
+                                                                            // skip-sample
+  Vehicle& operator=(Vehicle const&) = delete;                              // skip-sample
 
   void accelerate()
   { vptr_->accelerate(&buffer_); }
@@ -62,6 +87,8 @@ int main() {
   vehicles.push_back(Car{"Audi", 2017});
   vehicles.push_back(Truck{"Chevrolet", 2015});
   vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.emplace_back(in_place_type<Car>, "Toyota", 2012); // skip-sample
+  vehicles.back().emplace<Plane>("Airbus", "A380");          // skip-sample
 
   for (auto& vehicle : vehicles) {
     vehicle.accelerate();
@@ -1,12 +1,14 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
+#include "in_place.hpp"
 #include "vtable.hpp"
 
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -17,11 +19,28 @@ struct Vehicle {
     : vtbl_{vtable_for<Any>}
     , ptr_{new Any(vehicle)}
   { }
-                                                      // skip-sample
-  Vehicle(Vehicle const& other)                       // skip-sample
-    : vtbl_{other.vtbl_}                              // skip-sample
-    , ptr_{other.vtbl_.clone(other.ptr_)}             // skip-sample
-  { }                                                 // skip-sample
+                                                                        // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  Vehicle(in_place_type_t<Any>, Args&& ...args)                         // skip-sample
+    : vtbl_{vtable_for<Any>}                                            // skip-sample
+    , ptr_{new_object<Any>(std::forward<Args>(args)...)}                // skip-sample
+  { }                                                                   // skip-sample
+                                                                        // skip-sample
+  Vehicle(Vehicle const& other)                                         // skip-sample
+    : vtbl_{other.vtbl_}                                                // skip-sample
+    , ptr_{other.vtbl_.clone(other.ptr_)}                               // skip-sample
+  { }                                                                   // skip-sample
+                                                                        // skip-sample
+  // Replaces the vehicle by an `Any` constructed in its final storage. // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  void emplace(Args&& ...args) {                                        // skip-sample
+    void* ptr = new_object<Any>(std::forward<Args>(args)...);           // skip-sample
+    vtbl_.delete_(ptr_);                                                // skip-sample
+    vtbl_ = vtable_for<Any>;                                            // skip-sample
+    ptr_ = ptr;                                                         // skip-sample
+  }                                                                     // skip-sample
+                                                                        // skip-sample
+  Vehicle& operator=(Vehicle const&) = delete;                          // skip-sample
 
   void accelerate()
   { vtbl_.accelerate(ptr_); }
@@ -30,7 +49,7 @@ struct Vehicle {
   { vtbl_.delete_(ptr_); }
 
 private:
-  vtable const vtbl_; // <= not a pointer!
+  vtable vtbl_; // <= not a pointer!
   void* ptr_;
 };
 // end-sample
@@ -62,6 +81,8 @@ int main() {
   vehicles.push_back(Car{"Audi", 2017});
   vehicles.push_back(Truck{"Chevrolet", 2015});
   vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.emplace_back(in_place_type<Car>, "Toyota", 2012); // skip-sample
+  vehicles.back().emplace<Plane>("Airbus", "A380");          // skip-sample
 
   for (auto& vehicle : vehicles) {
     vehicle.accelerate();
@@ -0,0 +1,286 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "vtable.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// sample(packed_poly_vector)
+// A sequence of objects of different types and sizes, stored back to back
+// in a single buffer. Each object is preceded by a small header holding its
+// vtable and layout, so there is no per-object padding up to a fixed size,
+// and no size limit.
+//
+//  | header | pad | object | pad | header | object | header | pad | ...
+//
+// Erasing only destroys the object and marks it dead; `compact()` reclaims
+// the space of dead objects.
+class packed_poly_vector {
+  struct header {
+    vtable const* vptr;
+    std::uint32_t size;  // sizeof the object
+    std::uint16_t align; // alignof the object
+    bool alive;
+  };
+// end-sample
+
+  static std::size_t align_up(std::size_t n, std::size_t align)
+  { return (n + align - 1) & ~(align - 1); }
+
+  static std::size_t object_offset(std::size_t h, header const& hdr)
+  { return align_up(h + sizeof(header), hdr.align); }
+
+  static std::size_t next_offset(std::size_t h, header const& hdr)
+  { return align_up(object_offset(h, hdr) + hdr.size, alignof(header)); }
+
+  header& header_at(std::size_t h) const
+  { return *reinterpret_cast<header*>(buffer_ + h); }
+
+  void* object_at(std::size_t h) const
+  { return buffer_ + object_offset(h, header_at(h)); }
+
+public:
+  // A reference to an element, which is just an unpacked header.
+  struct element_ref {
+    vtable const* vptr;
+    void* ptr;
+    void accelerate() { vptr->accelerate(ptr); }
+  };
+
+  struct iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = element_ref;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = element_ref;
+
+    reference operator*() const
+    { return {self_->header_at(h_).vptr, self_->object_at(h_)}; }
+
+    iterator& operator++() {
+      h_ = self_->next_offset(h_, self_->header_at(h_));
+      skip_dead();
+      return *this;
+    }
+
+    iterator operator++(int) { iterator tmp = *this; ++*this; return tmp; }
+
+    friend bool operator==(iterator a, iterator b) { return a.h_ == b.h_; }
+    friend bool operator!=(iterator a, iterator b) { return a.h_ != b.h_; }
+
+  private:
+    friend class packed_poly_vector;
+    iterator(packed_poly_vector const* self, std::size_t h)
+      : self_{self}, h_{h}
+    { skip_dead(); }
+
+    void skip_dead() {
+      while (h_ != self_->used_ && !self_->header_at(h_).alive)
+        h_ = self_->next_offset(h_, self_->header_at(h_));
+    }
+
+    packed_poly_vector const* self_;
+    std::size_t h_;
+  };
+
+  packed_poly_vector() = default;
+  packed_poly_vector(packed_poly_vector const&) = delete;
+  packed_poly_vector& operator=(packed_poly_vector const&) = delete;
+
+  ~packed_poly_vector() {
+    for (element_ref r : *this)
+      r.vptr->dtor(r.ptr);
+    ::operator delete(buffer_);
+  }
+
+  template <typename T, typename ...Args>
+  element_ref emplace_back(Args&& ...args) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+      "over-aligned types are not supported");
+    static_assert(sizeof(T) <= std::numeric_limits<std::uint32_t>::max(),
+      "objects larger than 4 GB are not supported");
+    header hdr{&vtable_for<T>, sizeof(T), alignof(T), true};
+    std::size_t h = used_;
+    std::size_t end = next_offset(h, hdr);
+    if (end > capacity_) {
+      // Growing drops the dead elements, which moves the end of the buffer.
+      relocate(std::max(next_offset(live_bytes(), hdr), 2 * capacity_));
+      h = used_;
+      end = next_offset(h, hdr);
+    }
+
+    new (buffer_ + h) header(hdr);
+    void* object = object_at(h);
+    new (object) T(std::forward<Args>(args)...);
+    used_ = end; // only commit the element once it's constructed
+    ++size_;
+    return {hdr.vptr, object};
+  }
+
+  template <typename Any>
+  element_ref push_back(Any vehicle)
+  { return emplace_back<Any>(std::move(vehicle)); }
+
+  // Destroys the element; its space is reclaimed by the next `compact()`.
+  void erase(iterator it) {
+    header& hdr = header_at(it.h_);
+    hdr.vptr->dtor(object_at(it.h_));
+    hdr.alive = false;
+    --size_;
+  }
+
+  // Moves the live elements to a buffer that is just large enough for them.
+  void compact() { relocate(live_bytes()); }
+
+  iterator begin() const { return {this, 0}; }
+  iterator end() const { return {this, used_}; }
+
+  std::size_t size() const { return size_; }
+  std::size_t bytes_used() const { return used_; }
+
+private:
+  std::size_t live_bytes() const {
+    std::size_t bytes = 0;
+    for (std::size_t h = 0; h != used_; h = next_offset(h, header_at(h)))
+      if (header_at(h).alive)
+        bytes = next_offset(bytes, header_at(h));
+    return bytes;
+  }
+
+  // Moves the live elements to a new buffer of the given capacity, dropping
+  // dead elements along the way. Since both buffers are aligned for any
+  // type, the padding only depends on the offsets.
+  void relocate(std::size_t capacity) {
+    char* buffer = static_cast<char*>(::operator new(capacity));
+    std::size_t used = 0;
+    for (std::size_t h = 0; h != used_; h = next_offset(h, header_at(h))) {
+      header const& hdr = header_at(h);
+      if (!hdr.alive)
+        continue;
+      new (buffer + used) header(hdr);
+      hdr.vptr->move(buffer + object_offset(used, hdr), object_at(h));
+      hdr.vptr->dtor(object_at(h));
+      used = next_offset(used, hdr);
+    }
+    ::operator delete(buffer_);
+    buffer_ = buffer;
+    used_ = used;
+    capacity_ = capacity;
+  }
+
+  char* buffer_ = nullptr;
+  std::size_t used_ = 0;
+  std::size_t capacity_ = 0;
+  std::size_t size_ = 0;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> accelerated;
+
+// A tiny object: 4 bytes instead of 64 in `local_storage.cpp`.
+struct Bicycle {
+  int gears;
+  void accelerate() { accelerated.push_back("Bicycle " + std::to_string(gears)); }
+};
+
+struct Car {
+  std::string make;
+  int year;
+  void accelerate() { accelerated.push_back("Car " + make); }
+};
+
+// Too large to fit in `local_storage.cpp`'s 64 byte buffer.
+struct Plane {
+  std::string make;
+  std::string model;
+  double engines[8];
+  void accelerate() { accelerated.push_back("Plane " + make); }
+};
+
+struct alignas(16) Rocket {
+  double fuel;
+  void accelerate() {
+    assert(reinterpret_cast<std::uintptr_t>(this) % 16 == 0);
+    accelerated.push_back("Rocket");
+  }
+};
+
+// sample(main)
+int main() {
+  packed_poly_vector vehicles;
+
+  vehicles.push_back(Bicycle{21});
+  vehicles.push_back(Car{"Audi", 2017});
+  vehicles.push_back(Plane{"Boeing", "747", {}});
+  vehicles.emplace_back<Bicycle>(Bicycle{3});
+
+  for (auto vehicle : vehicles) {
+    vehicle.accelerate();
+  }
+// end-sample
+
+  assert(vehicles.size() == 4);
+  assert((accelerated == std::vector<std::string>{
+    "Bicycle 21", "Car Audi", "Plane Boeing", "Bicycle 3"
+  }));
+
+  // Alignment is respected, even across reallocations.
+  for (int i = 0; i != 100; ++i)
+    vehicles.push_back(i % 2 ? Rocket{1.0} : Rocket{2.0});
+  for (auto vehicle : vehicles)
+    vehicle.accelerate();
+
+  // Erase some elements and reclaim their space.
+  accelerated.clear();
+  std::size_t const before = vehicles.bytes_used();
+  for (auto it = vehicles.begin(); it != vehicles.end(); ) {
+    auto current = it++;
+    if ((*current).vptr == &vtable_for<Rocket>)
+      vehicles.erase(current);
+  }
+  vehicles.erase(vehicles.begin());
+  assert(vehicles.size() == 3);
+  vehicles.compact();
+  assert(vehicles.bytes_used() < before);
+
+  for (auto vehicle : vehicles)
+    vehicle.accelerate();
+  assert((accelerated == std::vector<std::string>{
+    "Car Audi", "Plane Boeing", "Bicycle 3"
+  }));
+
+  // Growing after erasing some elements drops them.
+  {
+    packed_poly_vector bicycles;
+    for (int i = 0; i != 4; ++i)
+      bicycles.push_back(Bicycle{i});
+    auto it = bicycles.begin();
+    bicycles.erase(it++);
+    bicycles.erase(++it);
+    for (int i = 4; i != 100; ++i)
+      bicycles.push_back(Bicycle{i});
+    assert(bicycles.size() == 98);
+
+    accelerated.clear();
+    for (auto bicycle : bicycles)
+      bicycle.accelerate();
+    std::vector<std::string> expected{"Bicycle 1", "Bicycle 3"};
+    for (int i = 4; i != 100; ++i)
+      expected.push_back("Bicycle " + std::to_string(i));
+    assert(accelerated == expected);
+  }
+// sample(main)
+}
+// end-sample
@@ -0,0 +1,40 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+// A plugin defining vehicles that the `runtime_registry` example doesn't
+// know about at compile time.
+
+#include "type_registry.hpp"
+
+
+// sample(plugin)
+struct Truck {
+  int speed = 0;
+  void accelerate() { speed += 2; }
+};
+
+struct Bus {
+  int speed = 0;
+  void accelerate() { speed += 1; }
+};
+
+extern "C" void register_types(type_registry& registry) {
+  registry.add<Truck>("Truck", {
+    {"accelerate", erase_fn(+[](void* self) {
+      static_cast<Truck*>(self)->accelerate();
+    })},
+    {"speed", erase_fn(+[](void const* self) {
+      return static_cast<Truck const*>(self)->speed;
+    })}
+  });
+
+  registry.add<Bus>("Bus", {
+    {"accelerate", erase_fn(+[](void* self) {
+      static_cast<Bus*>(self)->accelerate();
+    })},
+    {"speed", erase_fn(+[](void const* self) {
+      return static_cast<Bus const*>(self)->speed;
+    })}
+  });
+}
+// end-sample
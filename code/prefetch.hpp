@@ -0,0 +1,102 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+// Iterating over a collection of Vehicles whose objects live on the heap
+// means loading the Vehicle, then its vtable and its object, and the cache
+// misses on each element are only discovered once the previous element is
+// done. `prefetching_for_each` asks for the memory of element `i + distance`
+// while calling element `i`, so that the misses of several elements overlap.
+//
+// Elements must have a `prefetch()` method, which prefetches whatever
+// dispatching to them will touch (see `remote_storage.cpp`).
+
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <xmmintrin.h>
+#endif
+
+
+inline void prefetch(void const* p) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#elif defined(_MSC_VER)
+  _mm_prefetch(static_cast<char const*>(p), _MM_HINT_T0);
+#else
+  (void)p;
+#endif
+}
+
+// sample(prefetching_for_each)
+template <typename Iterator, typename F>
+void prefetching_for_each(Iterator first, Iterator last, F f,
+                          std::size_t distance) {
+  Iterator ahead = first;
+  for (std::size_t i = 0; i != distance && ahead != last; ++i, ++ahead)
+    ahead->prefetch();
+
+  for (; ahead != last; ++first, ++ahead) {
+    ahead->prefetch();
+    f(*first);
+  }
+  for (; first != last; ++first)
+    f(*first);
+}
+// end-sample
+
+// Finds a good prefetch distance for a traversal that is repeated many times,
+// e.g. once per frame. Every other traversal tries a distance twice as large
+// (or half as large) as the current one, and the tuner moves there when it is
+// faster per element. The best distance depends on the machine, on the cost
+// of `f` and on the size of the collection, so it can't be fixed in advance.
+class prefetch_tuner {
+public:
+  explicit prefetch_tuner(std::size_t distance = 8, std::size_t max = 256)
+    : distance_{distance}, max_{max}
+  { }
+
+  template <typename Iterator, typename F>
+  void for_each(Iterator first, Iterator last, F f) {
+    std::size_t const size = std::distance(first, last);
+    std::size_t const distance = probing_ ? probe() : distance_;
+    auto const start = std::chrono::steady_clock::now();
+    prefetching_for_each(first, last, f, distance);
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    if (size != 0)
+      record(distance, elapsed.count() / size);
+  }
+
+  std::size_t distance() const { return distance_; }
+
+private:
+  std::size_t probe() const {
+    if (increasing_)
+      return distance_ == 0 ? 1 : (distance_ * 2 > max_ ? max_ : distance_ * 2);
+    return distance_ / 2;
+  }
+
+  void record(std::size_t distance, double per_element) {
+    if (!probing_) {
+      current_ = per_element;
+    } else if (per_element < current_ * 0.97 && distance != distance_) {
+      distance_ = distance;
+    } else {
+      increasing_ = !increasing_; // no better this way, try the other one
+    }
+    probing_ = !probing_;
+  }
+
+  std::size_t distance_;
+  std::size_t max_;
+  double current_ = 0;
+  bool probing_ = false;
+  bool increasing_ = true;
+};
+
+#endif // header guard
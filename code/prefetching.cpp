@@ -0,0 +1,98 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "prefetch.hpp"
+#include "vtable.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+// sample(Vehicle)
+class Vehicle {
+  vtable const* const vptr_;
+  void* ptr_;
+
+public:
+  template <typename Any>
+  Vehicle(Any vehicle)
+    : vptr_{&vtable_for<Any>}
+    , ptr_{new Any(vehicle)}
+  { }
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}
+    , ptr_{other.vptr_->clone(other.ptr_)}
+  { }
+
+  void accelerate()
+  { vptr_->accelerate(ptr_); }
+
+  // Brings in everything `accelerate()` will need.
+  void prefetch() const
+  { ::prefetch(vptr_); ::prefetch(ptr_); }
+
+  ~Vehicle()
+  { vptr_->delete_(ptr_); }
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+std::vector<int> accelerated;
+
+struct Car {
+  int id;
+  void accelerate() { accelerated.push_back(id); }
+};
+
+struct Truck {
+  int id;
+  std::string make;
+  void accelerate() { accelerated.push_back(id); }
+};
+
+std::vector<int> iota(int n) {
+  std::vector<int> ids;
+  for (int i = 0; i != n; ++i)
+    ids.push_back(i);
+  return ids;
+}
+
+// sample(main)
+int main() {
+  std::vector<Vehicle> vehicles;
+  for (int i = 0; i != 100; ++i) {
+    if (i % 2) vehicles.push_back(Car{i});
+    else       vehicles.push_back(Truck{i, "Chevrolet"});
+  }
+
+  prefetching_for_each(vehicles.begin(), vehicles.end(), [](Vehicle& v) {
+    v.accelerate();
+  }, 8);
+// end-sample
+
+  // Every element is visited once, in order, whatever the distance.
+  assert(accelerated == iota(100));
+  for (std::size_t distance : {0, 1, 99, 100, 1000}) {
+    accelerated.clear();
+    prefetching_for_each(vehicles.begin(), vehicles.end(),
+                         [](Vehicle& v) { v.accelerate(); }, distance);
+    assert(accelerated == iota(100));
+  }
+
+  // The tuner keeps visiting every element while it searches for the best
+  // distance, and never goes beyond its maximum.
+  prefetch_tuner tuner{8, 32};
+  for (int frame = 0; frame != 50; ++frame) {
+    accelerated.clear();
+    tuner.for_each(vehicles.begin(), vehicles.end(),
+                   [](Vehicle& v) { v.accelerate(); });
+    assert(accelerated == iota(100));
+    assert(tuner.distance() <= 32);
+  }
+// sample(main)
+}
+// end-sample
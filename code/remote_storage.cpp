@@ -1,18 +1,21 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
+#include "in_place.hpp"
+#include "prefetch.hpp"
 #include "vtable.hpp"
 
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 
 // sample(Vehicle)
 class Vehicle {
-  vtable const* const vptr_;
+  vtable const* vptr_;
   void* ptr_;
 
 public:
@@ -24,9 +27,29 @@ public:
   { }
 
   Vehicle(Vehicle const& other); // implementation omitted
+                                                                        // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  Vehicle(in_place_type_t<Any>, Args&& ...args)                         // skip-sample
+    : vptr_{&vtable_for<Any>}                                           // skip-sample
+    , ptr_{new_object<Any>(std::forward<Args>(args)...)}                // skip-sample
+  { }                                                                   // skip-sample
+                                                                        // skip-sample
+  // Replaces the vehicle by an `Any` constructed in its final storage. // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  void emplace(Args&& ...args) {                                        // skip-sample
+    void* ptr = new_object<Any>(std::forward<Args>(args)...);           // skip-sample
+    vptr_->delete_(ptr_);                                               // skip-sample
+    vptr_ = &vtable_for<Any>;                                           // skip-sample
+    ptr_ = ptr;                                                         // skip-sample
+  }                                                                     // skip-sample
+                                                                        // skip-sample
+  Vehicle& operator=(Vehicle const&) = delete;                          // skip-sample
 
   void accelerate()
   { vptr_->accelerate(ptr_); }
+                                                      // skip-sample
+  void prefetch() const                               // skip-sample
+  { ::prefetch(vptr_); ::prefetch(ptr_); }            // skip-sample
 
   ~Vehicle()
   { vptr_->delete_(ptr_); }
@@ -64,6 +87,8 @@ int main() {
   vehicles.push_back(Car{"Audi", 2017});
   vehicles.push_back(Truck{"Chevrolet", 2015});
   vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.emplace_back(in_place_type<Car>, "Toyota", 2012); // skip-sample
+  vehicles.back().emplace<Plane>("Airbus", "A380");          // skip-sample
 
   for (auto& vehicle : vehicles) {
     vehicle.accelerate();
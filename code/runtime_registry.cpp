@@ -0,0 +1,143 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "type_registry.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The path of the plugin built from `plugins/trucks.cpp`.
+#if !defined(TRUCKS_PLUGIN)
+#  define TRUCKS_PLUGIN "./libtrucks.so"
+#endif
+
+
+type_registry& vehicle_types() {
+  static type_registry registry{{"accelerate", "speed"}};
+  return registry;
+}
+
+// sample(Vehicle)
+class Vehicle {
+  erased_fn const* vptr_;
+  void* ptr_;
+
+  template <typename Signature, typename ...Args>
+  decltype(auto) call(std::size_t slot, Args ...args) const
+  { return reinterpret_cast<Signature*>(vptr_[slot])(args...); }
+
+public:
+  // Creates a vehicle of the type registered under the given ID.
+  explicit Vehicle(std::uint64_t id) {
+    runtime_type const* type = vehicle_types().find(id);
+    if (type == nullptr)
+      throw std::invalid_argument{"unknown vehicle type"};
+    vptr_ = type->vtable.get();
+    ptr_ = type->create();
+  }
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}
+    , ptr_{other.call<void* (void const*)>(type_registry::clone_slot,
+                                           other.ptr_)}
+  { }
+
+  Vehicle& operator=(Vehicle const&) = delete;
+
+  void accelerate() {
+    // Resolved once, then just an index into the vtable.
+    static std::size_t const slot = vehicle_types().slot("accelerate");
+    call<void (void*)>(slot, ptr_);
+  }
+
+  int speed() const {
+    static std::size_t const slot = vehicle_types().slot("speed");
+    return call<int (void const*)>(slot, ptr_);
+  }
+
+  ~Vehicle()
+  { call<void (void*)>(type_registry::destroy_slot, ptr_); }
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+// A vehicle known at compile time, registered by the program itself.
+struct Car {
+  int speed = 0;
+  void accelerate() { speed += 3; }
+};
+
+void register_car(char const* name) {
+  vehicle_types().add<Car>(name, {
+    {"accelerate", erase_fn(+[](void* self) {
+      static_cast<Car*>(self)->accelerate();
+    })},
+    {"speed", erase_fn(+[](void const* self) {
+      return static_cast<Car const*>(self)->speed;
+    })}
+  });
+}
+
+// sample(main)
+int main() {
+  register_car("Car");
+  load_plugin(vehicle_types(), TRUCKS_PLUGIN);
+
+  std::vector<Vehicle> vehicles;
+  vehicles.emplace_back(stable_type_id("Car"));
+  vehicles.emplace_back(stable_type_id("Truck"));
+  vehicles.emplace_back(stable_type_id("Bus"));
+
+  for (auto& vehicle : vehicles) {
+    vehicle.accelerate();
+  }
+// end-sample
+
+  assert(vehicle_types().size() == 3);
+  assert(vehicles[0].speed() == 3);
+  assert(vehicles[1].speed() == 2);
+  assert(vehicles[2].speed() == 1);
+
+  // Copies are deep.
+  Vehicle copy = vehicles[1];
+  copy.accelerate();
+  assert(copy.speed() == 4);
+  assert(vehicles[1].speed() == 2);
+
+  // Unknown types and methods are reported.
+  assert(vehicle_types().find(stable_type_id("Plane")) == nullptr);
+  assert(vehicle_types().lookup(stable_type_id("Bus"), "speed") != nullptr);
+  try {
+    Vehicle plane{stable_type_id("Plane")};
+    assert(false);
+  } catch (std::invalid_argument const&) { }
+
+  // Types can only be registered once, and must implement every method.
+  try {
+    register_car("Truck");
+    assert(false);
+  } catch (std::invalid_argument const&) { }
+  try {
+    vehicle_types().add<Car>("Bicycle", {});
+    assert(false);
+  } catch (std::invalid_argument const&) { }
+  assert(vehicle_types().size() == 3);
+
+  // The perfect hash table keeps finding every type as more are registered.
+  std::vector<std::string> names;
+  for (int i = 0; i != 200; ++i)
+    names.push_back("Car" + std::to_string(i));
+  for (auto const& name : names)
+    register_car(name.c_str());
+  for (auto const& name : names)
+    assert(vehicle_types().find(stable_type_id(name.c_str()))->name == name);
+  assert(vehicle_types().find(stable_type_id("Truck"))->name == "Truck");
+  assert(vehicle_types().find(stable_type_id("Plane")) == nullptr);
+// sample(main)
+}
+// end-sample
@@ -1,18 +1,20 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
+#include "in_place.hpp"
 #include "vtable.hpp"
 
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 
 // sample(Vehicle)
 struct Vehicle {
-  vtable const* const vptr_;
+  vtable const* vptr_;
   union { void* ptr_;
           std::aligned_storage_t<16> buffer_; };
   bool on_heap_;
@@ -32,14 +34,50 @@ struct Vehicle {
   { vptr_->accelerate(on_heap_ ? ptr_ : &buffer_); }
 // end-sample
 
-  Vehicle(Vehicle const& other) : vptr_{other.vptr_} {
-    if (other.on_heap_) {
+  template <typename Any, typename ...Args>
+  Vehicle(in_place_type_t<Any>, Args&& ...args) : vptr_{&vtable_for<Any>} {
+    if (sizeof(Any) > 16) {
+      on_heap_ = true;
+      ptr_ = new_object<Any>(std::forward<Args>(args)...);
+    } else {
+      on_heap_ = false;
+      construct_object<Any>(&buffer_, std::forward<Args>(args)...);
+    }
+  }
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}, on_heap_{other.on_heap_}
+  {
+    if (on_heap_) {
       ptr_ = other.vptr_->clone(other.ptr_);
     } else {
       other.vptr_->copy(&buffer_, &other.buffer_);
     }
   }
 
+  // Replaces the vehicle by an `Any` constructed in its final storage. The
+  // old vehicle must be destroyed first when the new one goes in the buffer,
+  // so a throwing constructor would leave nothing to destroy; `noexcept`
+  // makes that terminate instead.
+  template <typename Any, typename ...Args>
+  void emplace(Args&& ...args) noexcept {
+    if (on_heap_) {
+      vptr_->delete_(ptr_);
+    } else {
+      vptr_->dtor(&buffer_);
+    }
+    vptr_ = &vtable_for<Any>;
+    if (sizeof(Any) > 16) {
+      on_heap_ = true;
+      ptr_ = new_object<Any>(std::forward<Args>(args)...);
+    } else {
+      on_heap_ = false;
+      construct_object<Any>(&buffer_, std::forward<Args>(args)...);
+    }
+  }
+
+  Vehicle& operator=(Vehicle const&) = delete;
+
   ~Vehicle() {
     if (on_heap_) {
       vptr_->delete_(ptr_);
@@ -79,6 +117,8 @@ int main() {
   vehicles.push_back(Car{"Audi", 2017});
   vehicles.push_back(Truck{"Chevrolet", 2015});
   vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.emplace_back(in_place_type<Car>, "Toyota", 2012); // skip-sample
+  vehicles.back().emplace<Plane>("Airbus", "A380");          // skip-sample
 
   for (auto& vehicle : vehicles) {
     vehicle.accelerate();
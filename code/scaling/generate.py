@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+# Copyright Louis Dionne 2017
+# Distributed under the Boost Software License, Version 1.0.
+
+"""
+Generates a program with N concrete types having M methods each, for each
+type erasure technique, in order to measure how compile times and binary
+sizes scale with the number of types and methods.
+
+Usage: generate.py OUTPUT_DIR TECHNIQUE TYPES METHODS
+Writes OUTPUT_DIR/TECHNIQUE.TYPESxMETHODS.cpp
+"""
+
+import os
+import sys
+
+
+def types(n, m):
+    out = []
+    for t in range(n):
+        out.append('struct T%d {' % t)
+        out.append('  int state = %d;' % t)
+        for k in range(m):
+            out.append('  int m%d(int x) { return x * %d + state; }' % (k, k + 1))
+        out.append('};')
+    return '\n'.join(out)
+
+
+def make_all(n, make):
+    return '\n'.join('  v.push_back(%s);' % make('T%d' % t) for t in range(n))
+
+
+def calls(m, call):
+    return '\n'.join('    sum += %s;' % call('m%d' % k) for k in range(m))
+
+
+def main_function(n, m, vector, make, call):
+    return '''
+int main() {{
+  {vector} v;
+{make}
+  int sum = 0;
+  for (auto& x : v) {{
+{calls}
+  }}
+  return sum == 0;
+}}
+'''.format(vector=vector, make=make_all(n, make), calls=calls(m, call))
+
+
+def inheritance(n, m):
+    base = 'struct Base {\n%s\n  virtual ~Base() { }\n};' % '\n'.join(
+        '  virtual int m%d(int x) = 0;' % k for k in range(m))
+    derived = 'template <typename T>\nstruct Derived final : Base {\n  T self;\n%s\n};' % '\n'.join(
+        '  int m%d(int x) override { return self.m%d(x); }' % (k, k) for k in range(m))
+    return '''#include <memory>
+#include <vector>
+
+{base}
+
+{derived}
+
+{types}
+{main}'''.format(base=base, derived=derived, types=types(n, m),
+                 main=main_function(n, m, 'std::vector<std::unique_ptr<Base>>',
+                                    lambda t: 'std::make_unique<Derived<%s>>()' % t,
+                                    lambda f: 'x->%s(1)' % f))
+
+
+def vtable(n, m):
+    members = '\n'.join('  int (*m%d)(void* this_, int x);' % k for k in range(m))
+    entries = ',\n'.join('  [](void* this_, int x) { return static_cast<T*>(this_)->m%d(x); }' % k
+                         for k in range(m))
+    methods = '\n'.join('  int m%d(int x) { return vptr_->m%d(ptr_, x); }' % (k, k) for k in range(m))
+    return '''#include <vector>
+
+struct vtable {{
+{members}
+  void (*delete_)(void* this_);
+  void* (*clone)(void const* this_);
+}};
+
+template <typename T>
+vtable const vtable_for = {{
+{entries},
+  [](void* this_) {{ delete static_cast<T*>(this_); }},
+  [](void const* this_) -> void* {{ return new T(*static_cast<T const*>(this_)); }}
+}};
+
+struct Any {{
+  template <typename T>
+  Any(T x) : vptr_{{&vtable_for<T>}}, ptr_{{new T(x)}} {{ }}
+  Any(Any const& other) : vptr_{{other.vptr_}}, ptr_{{other.vptr_->clone(other.ptr_)}} {{ }}
+  ~Any() {{ vptr_->delete_(ptr_); }}
+{methods}
+private:
+  vtable const* vptr_;
+  void* ptr_;
+}};
+
+{types}
+{main}'''.format(members=members, entries=entries, methods=methods, types=types(n, m),
+                 main=main_function(n, m, 'std::vector<Any>',
+                                    lambda t: '%s{}' % t, lambda f: 'x.%s(1)' % f))
+
+
+def dyno(vtable_policy):
+    def generate(n, m):
+        functions = ',\n'.join('  "m%d"_s = dyno::function<int (dyno::T&, int)>' % k for k in range(m))
+        mappings = ',\n'.join('  "m%d"_s = [](T& self, int x) { return self.m%d(x); }' % (k, k)
+                              for k in range(m))
+        methods = '\n'.join('  int m%d(int x) { return poly_.virtual_("m%d"_s)(poly_, x); }' % (k, k)
+                            for k in range(m))
+        return '''#include <dyno.hpp>
+
+#include <vector>
+using namespace dyno::literals;
+
+struct Interface : decltype(dyno::requires(
+  dyno::CopyConstructible{{}},
+  dyno::Destructible{{}},
+{functions}
+)) {{ }};
+
+template <typename T>
+auto const dyno::default_concept_map<Interface, T> = dyno::make_concept_map(
+{mappings}
+);
+
+struct Any {{
+  template <typename T>
+  Any(T x) : poly_{{x}} {{ }}
+{methods}
+private:
+  dyno::poly<Interface, dyno::remote_storage, {vtable_policy}> poly_;
+}};
+
+{types}
+{main}'''.format(functions=functions, mappings=mappings, methods=methods,
+                 vtable_policy=vtable_policy, types=types(n, m),
+                 main=main_function(n, m, 'std::vector<Any>',
+                                    lambda t: '%s{}' % t, lambda f: 'x.%s(1)' % f))
+    return generate
+
+
+TECHNIQUES = {
+    'inheritance': inheritance,
+    'vtable': vtable,
+    'dyno_remote_vtable': dyno('dyno::vtable<dyno::remote<dyno::everything>>'),
+    'dyno_local_vtable': dyno('dyno::vtable<dyno::local<dyno::everything>>'),
+    'dyno_joined_vtable': dyno('dyno::vtable<dyno::local<dyno::only<decltype("m0"_s)>>, '
+                               'dyno::remote<dyno::everything_else>>'),
+}
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 5 or sys.argv[2] not in TECHNIQUES:
+        sys.exit('usage: %s OUTPUT_DIR {%s} TYPES METHODS' % (sys.argv[0], ','.join(TECHNIQUES)))
+    output_dir, technique, n, m = sys.argv[1], sys.argv[2], int(sys.argv[3]), int(sys.argv[4])
+    path = os.path.join(output_dir, '%s.%dx%d.cpp' % (technique, n, m))
+    source = TECHNIQUES[technique](n, m)
+    # Only touch the file when it changes, to avoid needless rebuilds.
+    if not os.path.exists(path) or open(path).read() != source:
+        with open(path, 'w') as f:
+            f.write(source)
@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+# Copyright Louis Dionne 2017
+# Distributed under the Boost Software License, Version 1.0.
+
+"""
+Runs a compiler or linker command and records its wall-clock time and peak
+memory usage. This is used as a CMake rule launcher.
+
+Usage: measure.py OUTPUT_FILE COMMAND [ARGS...]
+Writes "seconds peak_kilobytes" to OUTPUT_FILE.
+"""
+
+import os
+import subprocess
+import sys
+import time
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3:
+        sys.exit('usage: %s OUTPUT_FILE COMMAND [ARGS...]' % sys.argv[0])
+    output, command = sys.argv[1], sys.argv[2:]
+
+    start = time.time()
+    process = subprocess.Popen(command)
+    _, status, usage = os.wait4(process.pid, 0)
+    elapsed = time.time() - start
+    returncode = os.waitstatus_to_exitcode(status) if hasattr(os, 'waitstatus_to_exitcode') \
+                 else (status >> 8)
+
+    # ru_maxrss is in kilobytes on Linux, but in bytes on macOS.
+    peak_kb = usage.ru_maxrss // 1024 if sys.platform == 'darwin' else usage.ru_maxrss
+    if returncode == 0:
+        with open(output, 'w') as f:
+            f.write('%f %d\n' % (elapsed, peak_kb))
+    sys.exit(returncode)
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# Copyright Louis Dionne 2017
+# Distributed under the Boost Software License, Version 1.0.
+
+"""
+Prints the compile time, peak compiler memory and binary size of each of the
+programs generated by generate.py, as recorded by measure.py.
+
+Usage: report.py MEASUREMENTS_DIR BINARY_DIR PROGRAM...
+"""
+
+import os
+import subprocess
+import sys
+
+
+def read_measurement(path):
+    try:
+        with open(path) as f:
+            seconds, peak_kb = f.read().split()
+            return float(seconds), int(peak_kb)
+    except (IOError, ValueError):
+        return None, None
+
+
+def text_size(binary):
+    """Returns the size of the .text section, or None if it can't be found."""
+    try:
+        output = subprocess.check_output(['size', '-A', binary], universal_newlines=True)
+    except (OSError, subprocess.CalledProcessError):
+        return None
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in ('.text', '__text'):
+            return int(fields[1])
+    return None
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3:
+        sys.exit('usage: %s MEASUREMENTS_DIR BINARY_DIR PROGRAM...' % sys.argv[0])
+    measurements, binaries, programs = sys.argv[1], sys.argv[2], sys.argv[3:]
+
+    header = ('program', 'compile (s)', 'peak memory (MB)', 'link (s)', 'binary (KB)', '.text (KB)')
+    print('%-36s %12s %17s %9s %12s %11s' % header)
+    for program in programs:
+        compile_s, compile_kb = read_measurement(os.path.join(measurements, program + '.compile'))
+        link_s, _ = read_measurement(os.path.join(measurements, program + '.link'))
+        binary = os.path.join(binaries, program)
+        size = os.path.getsize(binary) if os.path.exists(binary) else None
+        text = text_size(binary) if size is not None else None
+
+        def show(value, fmt, scale=1):
+            return fmt % (value / scale) if value is not None else 'n/a'
+        print('%-36s %12s %17s %9s %12s %11s' % (
+            program,
+            show(compile_s, '%.2f'),
+            show(compile_kb, '%.1f', 1024.0),
+            show(link_s, '%.2f'),
+            show(size, '%.1f', 1024.0),
+            show(text, '%.1f', 1024.0)))
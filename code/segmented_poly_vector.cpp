@@ -0,0 +1,192 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "allocations.hpp"
+#include "vtable.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// sample(segmented_poly_vector)
+// A collection of objects of different types, where the objects of each type
+// are stored contiguously in their own segment:
+//
+//  Car:   | Car | Car | Car |     |
+//  Truck: | Truck | Truck |
+//
+// Since a segment only holds objects of one type, clearing the collection
+// destroys each segment with a single call through the vtable, which runs
+// a non-virtual loop over `T::~T` or nothing at all when `T` is trivially
+// destructible, and the memory of each segment is released at once.
+class segmented_poly_vector {
+  struct segment {
+    vtable const* vptr;
+    char* data;
+    std::size_t size;     // number of objects
+    std::size_t capacity; // in objects
+    std::size_t stride;   // sizeof the objects
+  };
+// end-sample
+
+public:
+  segmented_poly_vector() = default;
+  segmented_poly_vector(segmented_poly_vector const&) = delete;
+  segmented_poly_vector& operator=(segmented_poly_vector const&) = delete;
+
+  // sample(clear)
+  ~segmented_poly_vector() {
+    clear();
+    for (segment& s : segments_)
+      ::operator delete(s.data);
+  }
+
+  // Destroys all the objects, but keeps the memory of the segments around
+  // so that filling the collection again doesn't allocate.
+  void clear() {
+    for (segment& s : segments_) {
+      s.vptr->dtor_n(s.data, s.size);
+      s.size = 0;
+    }
+  }
+  // end-sample
+
+  template <typename T, typename ...Args>
+  void emplace_back(Args&& ...args) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+      "over-aligned types are not supported");
+    segment& s = segment_for<T>();
+    if (s.size == s.capacity)
+      grow<T>(s, std::max<std::size_t>(8, 2 * s.capacity));
+    new (s.data + s.size * sizeof(T)) T(std::forward<Args>(args)...);
+    ++s.size;
+  }
+
+  template <typename Any>
+  void push_back(Any vehicle)
+  { emplace_back<Any>(std::move(vehicle)); }
+
+  // Accelerates every vehicle, one segment at a time.
+  void accelerate() {
+    for (segment& s : segments_)
+      for (std::size_t i = 0; i != s.size; ++i)
+        s.vptr->accelerate(s.data + i * s.stride);
+  }
+
+  std::size_t size() const {
+    std::size_t total = 0;
+    for (segment const& s : segments_)
+      total += s.size;
+    return total;
+  }
+
+  // Number of distinct types ever stored.
+  std::size_t segments() const { return segments_.size(); }
+
+private:
+  template <typename T>
+  segment& segment_for() {
+    vtable const* vptr = &vtable_for<T>;
+    auto it = index_.find(vptr);
+    if (it != index_.end())
+      return segments_[it->second];
+    segments_.push_back({vptr, nullptr, 0, 0, sizeof(T)});
+    index_.emplace(vptr, segments_.size() - 1);
+    return segments_.back();
+  }
+
+  // Moves the objects of a segment to a larger buffer. We know the type
+  // statically here, so there's no need to go through the vtable.
+  template <typename T>
+  void grow(segment& s, std::size_t capacity) {
+    char* data = static_cast<char*>(::operator new(capacity * sizeof(T)));
+    T* from = reinterpret_cast<T*>(s.data);
+    T* to = reinterpret_cast<T*>(data);
+    for (std::size_t i = 0; i != s.size; ++i) {
+      new (to + i) T(std::move(from[i]));
+      from[i].~T();
+    }
+    ::operator delete(s.data);
+    s.data = data;
+    s.capacity = capacity;
+  }
+
+  std::vector<segment> segments_;
+  std::unordered_map<vtable const*, std::size_t> index_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+int accelerated = 0;
+int destroyed = 0;
+
+// Trivially destructible: clearing its segment does nothing at all.
+struct Bicycle {
+  int gears;
+  void accelerate() { ++accelerated; }
+};
+
+struct Car {
+  std::string make;
+  int year;
+  void accelerate() { ++accelerated; }
+};
+
+struct Truck {
+  std::string make;
+  int year;
+  bool counted = true;
+  Truck(std::string make, int year) : make{make}, year{year} { }
+  Truck(Truck const&) = default;
+  Truck(Truck&& other)
+    : make{std::move(other.make)}, year{other.year}
+  { other.counted = false; }
+  ~Truck() { if (counted) ++destroyed; }
+  void accelerate() { ++accelerated; }
+};
+
+// sample(main)
+int main() {
+  segmented_poly_vector vehicles;
+
+  for (int i = 0; i != 100; ++i) {
+    vehicles.push_back(Car{"Audi", 2017});
+    vehicles.emplace_back<Truck>("Chevrolet", 2015);
+    vehicles.push_back(Bicycle{21});
+  }
+
+  vehicles.accelerate();
+// end-sample
+  assert(accelerated == 300);
+  assert(vehicles.size() == 300);
+  assert(vehicles.segments() == 3);
+
+  // Clearing destroys every object, without releasing any memory.
+  {
+    allocation_counter counter;
+    vehicles.clear();
+    assert(counter.deallocations() == 0);
+  }
+  assert(destroyed == 100);
+  assert(vehicles.size() == 0);
+
+  // Refilling the collection reuses the segments.
+  {
+    allocation_counter counter;
+    for (int i = 0; i != 100; ++i) {
+      vehicles.push_back(Bicycle{3});
+      vehicles.emplace_back<Truck>("Ford", 2010);
+    }
+    assert(counter.allocations() == 0);
+  }
+  assert(vehicles.size() == 200);
+  assert(vehicles.segments() == 3);
+// sample(main)
+}
+// end-sample
@@ -1,18 +1,22 @@
 // Copyright Louis Dionne 2017
 // Distributed under the Boost Software License, Version 1.0.
 
+#include "in_place.hpp"
+#include "prefetch.hpp"
 #include "vtable.hpp"
 
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 
 // sample(Vehicle)
 class Vehicle {
-  vtable const* const vptr_;
+  vtable const* vptr_;
   std::shared_ptr<void> ptr_;
 
 public:
@@ -21,9 +25,27 @@ public:
     : vptr_{&vtable_for<Any>}
     , ptr_{std::make_shared<Any>(vehicle)}
   { }
+                                                                        // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  Vehicle(in_place_type_t<Any>, Args&& ...args)                         // skip-sample
+    : vptr_{&vtable_for<Any>}                                           // skip-sample
+    , ptr_{make_shared_object<Any>(                                     // skip-sample
+        std::forward<Args>(args)...)}                                   // skip-sample
+  { }                                                                   // skip-sample
+                                                                        // skip-sample
+  // Replaces the vehicle by an `Any` constructed in its final storage. // skip-sample
+  // Copies made before keep sharing the previous vehicle.              // skip-sample
+  template <typename Any, typename ...Args>                             // skip-sample
+  void emplace(Args&& ...args) {                                        // skip-sample
+    ptr_ = make_shared_object<Any>(std::forward<Args>(args)...);        // skip-sample
+    vptr_ = &vtable_for<Any>;                                           // skip-sample
+  }                                                                     // skip-sample
 
   void accelerate()
   { vptr_->accelerate(ptr_.get()); }
+                                                      // skip-sample
+  void prefetch() const                               // skip-sample
+  { ::prefetch(vptr_); ::prefetch(ptr_.get()); }      // skip-sample
 };
 // end-sample
 
@@ -55,6 +77,8 @@ int main() {
   vehicles.push_back(Car{"Audi", 2017});
   vehicles.push_back(Truck{"Chevrolet", 2015});
   vehicles.push_back(Plane{"Boeing", "747"});
+  vehicles.emplace_back(in_place_type<Car>, "Toyota", 2012); // skip-sample
+  vehicles.back().emplace<Plane>("Airbus", "A380");          // skip-sample
 
   for (auto& vehicle : vehicles) {
     vehicle.accelerate();
@@ -0,0 +1,134 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "allocations.hpp"
+#include "small_poly_vector.hpp"
+#include "vtable.dyno.hpp"
+
+#include <dyno.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+using namespace dyno::literals;
+
+
+int accelerated = 0;
+
+// A vehicle of a given size, which performs no allocations of its own.
+template <std::size_t Size>
+struct Payload {
+  char data[Size];
+  void accelerate() { ++accelerated; }
+};
+
+// sample(Convoy)
+// Convoys are usually made of a few vehicles, which are stored in the convoy
+// itself along with their small buffers.
+struct Convoy {
+  small_poly_vector<IVehicle, 4, dyno::sbo_storage<16>> vehicles;
+
+  void accelerate() {
+    for (auto& vehicle : vehicles)
+      vehicle.virtual_("accelerate"_s)(vehicle);
+  }
+};
+// end-sample
+
+int main() {
+  // A small convoy doesn't allocate.
+  {
+    allocation_counter counter;
+    Convoy convoy;
+    for (int i = 0; i != 4; ++i)
+      convoy.vehicles.push_back(Payload<16>{});
+    convoy.accelerate();
+    assert(accelerated == 4);
+    assert(convoy.vehicles.is_inline());
+    assert(counter.allocations() == 0);
+
+    // Neither does copying or moving it.
+    Convoy copy = convoy;
+    Convoy moved = std::move(copy);
+    assert(copy.vehicles.empty());
+    assert(moved.vehicles.size() == 4);
+    moved.accelerate();
+    assert(accelerated == 8);
+    assert(counter.allocations() == 0);
+  }
+
+  // Past `N` elements, the elements are moved to a single heap buffer.
+  {
+    Convoy convoy;
+    for (int i = 0; i != 4; ++i)
+      convoy.vehicles.push_back(Payload<16>{});
+
+    allocation_counter counter;
+    convoy.vehicles.push_back(Payload<16>{});
+    assert(counter.allocations() == 1);
+    assert(!convoy.vehicles.is_inline());
+    assert(convoy.vehicles.capacity() == 8);
+    assert(convoy.vehicles.size() == 5);
+
+    // Moving a vector on the heap steals its buffer.
+    counter.reset();
+    Convoy moved = std::move(convoy);
+    assert(counter.allocations() == 0);
+    assert(convoy.vehicles.empty() && convoy.vehicles.is_inline());
+    assert(moved.vehicles.size() == 5);
+
+    accelerated = 0;
+    moved.accelerate();
+    assert(accelerated == 5);
+  }
+
+  // Relocating vehicles that don't fit in the small buffers only moves the
+  // pointers to them.
+  {
+    Convoy convoy;
+    for (int i = 0; i != 4; ++i)
+      convoy.vehicles.push_back(Payload<64>{});
+
+    allocation_counter counter;
+    convoy.vehicles.reserve(16);
+    assert(counter.allocations() == 1);
+    assert(counter.deallocations() == 0);
+
+    accelerated = 0;
+    convoy.accelerate();
+    assert(accelerated == 4);
+  }
+
+  // Assignment, between inline and heap vectors.
+  {
+    Convoy small, large;
+    small.vehicles.push_back(Payload<8>{});
+    for (int i = 0; i != 10; ++i)
+      large.vehicles.push_back(Payload<8>{});
+
+    small = large;
+    assert(small.vehicles.size() == 10 && large.vehicles.size() == 10);
+    large.vehicles.clear();
+    large.vehicles.push_back(Payload<64>{});
+    small = std::move(large);
+    assert(small.vehicles.size() == 1);
+    small.vehicles.pop_back();
+    assert(small.vehicles.empty());
+  }
+
+  // Pushing one of our own elements when growing.
+  {
+    Convoy convoy;
+    for (int i = 0; i != 4; ++i)
+      convoy.vehicles.push_back(Payload<8>{});
+    convoy.vehicles.push_back(convoy.vehicles[0]); // inline to heap
+    for (int i = 0; i != 3; ++i)
+      convoy.vehicles.push_back(Payload<64>{});
+    convoy.vehicles.push_back(convoy.vehicles[7]); // heap to heap
+    assert(convoy.vehicles.size() == 9);
+
+    accelerated = 0;
+    convoy.accelerate();
+    assert(accelerated == 9);
+  }
+}
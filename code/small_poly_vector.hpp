@@ -0,0 +1,172 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef SMALL_POLY_VECTOR_HPP
+#define SMALL_POLY_VECTOR_HPP
+
+// A vector of type-erased objects that keeps its first `N` elements inside
+// itself. Objects owning a few Vehicles or functions usually pay for the
+// buffer of a `std::vector`, and then for each element that doesn't fit in
+// its small buffer. With `small_poly_vector` and a storage policy with a
+// small buffer, the common case of a few small elements allocates nothing,
+// and the heap is only used past `N` elements.
+
+#include <dyno.hpp>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// sample(small_poly_vector)
+template <typename Concept, std::size_t N,
+          typename Storage = dyno::sbo_storage<16>>
+class small_poly_vector {
+public:
+  using value_type = dyno::poly<Concept, Storage>;
+
+  small_poly_vector() : data_{inline_data()}, size_{0}, capacity_{N} { }
+// end-sample
+  static_assert(N > 0, "use a std::vector instead");
+
+  small_poly_vector(small_poly_vector const& other) : small_poly_vector{} {
+    reserve(other.size_);
+    for (value_type const& x : other)
+      new (data_ + size_++) value_type{x};
+  }
+
+  small_poly_vector(small_poly_vector&& other) : small_poly_vector{}
+  { take(std::move(other)); }
+
+  small_poly_vector& operator=(small_poly_vector const& other) {
+    if (this != &other)
+      *this = small_poly_vector{other};
+    return *this;
+  }
+
+  small_poly_vector& operator=(small_poly_vector&& other) {
+    if (this != &other) {
+      release();
+      data_ = inline_data();
+      capacity_ = N;
+      take(std::move(other));
+    }
+    return *this;
+  }
+
+  ~small_poly_vector()
+  { release(); }
+
+  template <typename Any>
+  value_type& push_back(Any&& x) {
+    value_type* element;
+    if (size_ == capacity_) {
+      // `x` may be one of our elements, so it is copied to the new buffer
+      // before the elements are moved, like `std::vector` does.
+      value_type* data = allocate(2 * capacity_);
+      try {
+        element = new (data + size_) value_type{std::forward<Any>(x)};
+      } catch (...) {
+        ::operator delete(data);
+        throw;
+      }
+      move_to(data, 2 * capacity_);
+    } else {
+      element = new (data_ + size_) value_type{std::forward<Any>(x)};
+    }
+    ++size_;
+    return *element;
+  }
+
+  void pop_back()
+  { data_[--size_].~value_type(); }
+
+  void reserve(std::size_t capacity) {
+    if (capacity > capacity_)
+      relocate(capacity);
+  }
+
+  void clear() {
+    for (std::size_t i = 0; i != size_; ++i)
+      data_[i].~value_type();
+    size_ = 0;
+  }
+
+  value_type& operator[](std::size_t i) { return data_[i]; }
+  value_type const& operator[](std::size_t i) const { return data_[i]; }
+
+  value_type* begin() { return data_; }
+  value_type* end() { return data_ + size_; }
+  value_type const* begin() const { return data_; }
+  value_type const* end() const { return data_ + size_; }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  // Whether the elements are stored inside the vector itself.
+  bool is_inline() const { return data_ == inline_data(); }
+
+private:
+  value_type* inline_data()
+  { return reinterpret_cast<value_type*>(&inline_); }
+
+  value_type const* inline_data() const
+  { return reinterpret_cast<value_type const*>(&inline_); }
+
+  static value_type* allocate(std::size_t capacity) {
+    return static_cast<value_type*>(
+      ::operator new(capacity * sizeof(value_type)));
+  }
+
+  void relocate(std::size_t capacity)
+  { move_to(allocate(capacity), capacity); }
+
+  // Moves the elements to a heap buffer with the given capacity. Each poly
+  // is moved and then destroyed, which only moves the objects that live in
+  // the small buffers, and steals the pointer to those on the heap.
+  void move_to(value_type* data, std::size_t capacity) {
+    for (std::size_t i = 0; i != size_; ++i) {
+      new (data + i) value_type{std::move(data_[i])};
+      data_[i].~value_type();
+    }
+    if (!is_inline())
+      ::operator delete(data_);
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  // Takes the elements of `other`, assuming that we are empty and inline.
+  // When `other` is on the heap, we simply take its buffer.
+  void take(small_poly_vector&& other) {
+    if (other.is_inline()) {
+      for (std::size_t i = 0; i != other.size_; ++i)
+        new (data_ + i) value_type{std::move(other.data_[i])};
+      size_ = other.size_;
+      other.clear();
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_data();
+      other.size_ = 0;
+      other.capacity_ = N;
+    }
+  }
+
+  void release() {
+    clear();
+    if (!is_inline())
+      ::operator delete(data_);
+  }
+
+// sample(small_poly_vector)
+  value_type* data_;
+  std::size_t size_;
+  std::size_t capacity_;
+  std::aligned_storage_t<sizeof(value_type), alignof(value_type)> inline_[N];
+};
+// end-sample
+
+#endif // header guard
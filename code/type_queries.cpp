@@ -0,0 +1,142 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "vtable.hpp"
+
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// sample(Vehicle)
+// Since there is exactly one vtable per type, comparing the vtable pointer of
+// a Vehicle with `&vtable_for<T>` tells whether it holds a `T`, without any
+// RTTI. This assumes that `vtable_for<T>` is not duplicated, which can happen
+// when objects cross the boundary of a shared library built with hidden
+// symbols.
+class Vehicle {
+  vtable const* const vptr_;
+  void* ptr_;
+
+public:
+  template <typename Any>
+  Vehicle(Any vehicle)
+    : vptr_{&vtable_for<Any>}
+    , ptr_{new Any(std::move(vehicle))}
+  { }
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}
+    , ptr_{other.vptr_->clone(other.ptr_)}
+  { }
+
+  void accelerate()
+  { vptr_->accelerate(ptr_); }
+
+  template <typename T>
+  bool holds() const
+  { return vptr_ == &vtable_for<T>; }
+
+  // Precondition: holds<T>()
+  template <typename T>
+  T& unsafe_get() {
+    assert(holds<T>());
+    return *static_cast<T*>(ptr_);
+  }
+
+  template <typename T>
+  T const& unsafe_get() const {
+    assert(holds<T>());
+    return *static_cast<T const*>(ptr_);
+  }
+
+  // Calls `f` with the object as its actual type if it is one of `Ts...`,
+  // and returns whether `f` was called. `f` is called with a statically
+  // known type, so it can be inlined.
+  template <typename ...Ts, typename F>
+  bool visit_as(F&& f) {
+    bool visited = false;
+    using expand = int[];
+    (void)expand{0, (visited = visited ||
+                               (holds<Ts>() && (f(unsafe_get<Ts>()), true)))...};
+    return visited;
+  }
+
+  ~Vehicle()
+  { vptr_->delete_(ptr_); }
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+int dispatched = 0;
+
+struct Car {
+  std::string make;
+  int year;
+  int speed = 0;
+  void accelerate() { ++dispatched; speed += 1; }
+};
+
+struct Truck {
+  std::string make;
+  int year;
+  int speed = 0;
+  void accelerate() { ++dispatched; speed += 2; }
+};
+
+struct Plane {
+  std::string make;
+  std::string model;
+  int speed = 0;
+  void accelerate() { ++dispatched; speed += 3; }
+};
+
+// sample(main)
+int main() {
+  std::vector<Vehicle> vehicles;
+  for (int i = 0; i != 10; ++i)
+    vehicles.push_back(Car{"Audi", 2017});
+  vehicles.push_back(Truck{"Chevrolet", 2015});
+  vehicles.push_back(Plane{"Boeing", "747"});
+
+  // Cars are by far the most common, so they get a path with no indirect
+  // call, and everything else goes through the vtable.
+  for (auto& vehicle : vehicles) {
+    bool const fast = vehicle.visit_as<Car>([](Car& car) {
+      car.speed += 1;
+    });
+    if (!fast)
+      vehicle.accelerate();
+  }
+// end-sample
+  assert(dispatched == 2);
+  assert(vehicles[0].unsafe_get<Car>().speed == 1);
+  assert(vehicles[10].unsafe_get<Truck>().speed == 2);
+  assert(vehicles[11].unsafe_get<Plane>().speed == 3);
+
+  assert(vehicles[0].holds<Car>());
+  assert(!vehicles[0].holds<Truck>());
+  assert(!vehicles[11].holds<Car>());
+
+  // Copies hold the same type.
+  Vehicle const copy = vehicles[10];
+  assert(copy.holds<Truck>());
+  assert(copy.unsafe_get<Truck>().make == "Chevrolet");
+
+  // `visit_as` tries the types in order, and calls `f` at most once.
+  int calls = 0;
+  bool visited = vehicles[11].visit_as<Car, Plane, Truck>([&](auto& v) {
+    ++calls;
+    v.speed = 0;
+  });
+  assert(visited && calls == 1);
+  assert(vehicles[11].unsafe_get<Plane>().speed == 0);
+
+  visited = vehicles[11].visit_as<Car, Truck>([&](auto&) { ++calls; });
+  assert(!visited && calls == 1);
+  assert(!vehicles[0].visit_as<>([&](auto&) { ++calls; }));
+// sample(main)
+}
+// end-sample
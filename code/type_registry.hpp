@@ -0,0 +1,207 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#ifndef TYPE_REGISTRY_HPP
+#define TYPE_REGISTRY_HPP
+
+// A registry of types known only at runtime, e.g. types defined in plugins.
+//
+// The registry is created with the list of methods of the interface. Each
+// type is registered under a stable ID (a hash of its name, so it is the same
+// in every process) along with an implementation of each method, and the
+// methods are resolved right away into a vtable that is laid out exactly
+// like a static one:
+//
+//  | destroy | clone | method 0 | method 1 | ... |
+//
+// Method names are resolved to slots in that vtable once per call site, and
+// stable IDs are resolved to types through a perfect hash table that is
+// rebuilt when a type is registered, so that dispatching costs the same as
+// with a static vtable and creating an object from an ID costs a single
+// multiplication and probe.
+//
+// Registering types is not thread safe, and types can't be unregistered,
+// since objects may still refer to their vtable.
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <dlfcn.h>
+#endif
+
+
+// The type of the functions stored in a runtime vtable. They must be cast
+// back to their actual type before being called.
+using erased_fn = void (*)();
+
+template <typename F>
+erased_fn erase_fn(F* f)
+{ return reinterpret_cast<erased_fn>(f); }
+
+// The stable ID of a type, which is the 64 bit FNV-1a hash of its name.
+constexpr std::uint64_t stable_type_id(char const* name,
+                                       std::uint64_t hash = 0xcbf29ce484222325)
+{
+  return *name == '\0'
+    ? hash
+    : stable_type_id(name + 1, (hash ^ static_cast<unsigned char>(*name))
+                                 * 0x100000001b3);
+}
+
+struct runtime_type {
+  std::uint64_t id;
+  std::string name;
+  void* (*create)();
+  std::unique_ptr<erased_fn[]> vtable;
+};
+
+class type_registry {
+public:
+  // Slots of the functions every type provides.
+  static constexpr std::size_t destroy_slot = 0;
+  static constexpr std::size_t clone_slot = 1;
+
+  explicit type_registry(std::vector<std::string> methods)
+    : methods_(std::move(methods))
+  { rehash(); }
+
+  type_registry(type_registry const&) = delete;
+  type_registry& operator=(type_registry const&) = delete;
+
+  // Returns the vtable slot of a method. This compares the name with every
+  // method of the interface, so it is meant to be called once per call site,
+  // when loading code, and cached.
+  std::size_t slot(std::string const& method) const {
+    for (std::size_t i = 0; i != methods_.size(); ++i)
+      if (methods_[i] == method)
+        return 2 + i;
+    throw std::invalid_argument{"unknown method " + method};
+  }
+
+  // Registers a type with the given implementation of each method of the
+  // interface. Throws if a method is missing or the type is already known.
+  void add(char const* name, void* (*create)(), void (*destroy)(void*),
+           void* (*clone)(void const*),
+           std::initializer_list<std::pair<char const*, erased_fn>> methods) {
+    std::uint64_t const id = stable_type_id(name);
+    if (find(id) != nullptr)
+      throw std::invalid_argument{std::string{"type "} + name +
+                                  " is already registered"};
+
+    std::unique_ptr<erased_fn[]> vtable{new erased_fn[2 + methods_.size()]()};
+    vtable[destroy_slot] = erase_fn(destroy);
+    vtable[clone_slot] = erase_fn(clone);
+    for (auto const& method : methods)
+      vtable[slot(method.first)] = method.second;
+    for (std::size_t i = 0; i != methods_.size(); ++i)
+      if (vtable[2 + i] == nullptr)
+        throw std::invalid_argument{std::string{"type "} + name +
+                                    " does not implement " + methods_[i]};
+
+    types_.push_back(std::unique_ptr<runtime_type>{
+      new runtime_type{id, name, create, std::move(vtable)}
+    });
+    rehash();
+  }
+
+  // Registers a default constructible and copyable type `T`.
+  template <typename T>
+  void add(char const* name,
+           std::initializer_list<std::pair<char const*, erased_fn>> methods) {
+    add(name,
+        []() -> void* { return new T(); },
+        [](void* self) { delete static_cast<T*>(self); },
+        [](void const* self) -> void* {
+          return new T(*static_cast<T const*>(self));
+        },
+        methods);
+  }
+
+  // Returns the type with the given ID, or null if there is none.
+  runtime_type const* find(std::uint64_t id) const {
+    runtime_type const* type = table_[(id * seed_) >> shift_];
+    return type != nullptr && type->id == id ? type : nullptr;
+  }
+
+  // Returns the implementation of a method for a type, or null if the type
+  // is unknown. Like `slot`, this looks the method up by name, so it is meant
+  // for loading code, not for dispatching calls.
+  erased_fn lookup(std::uint64_t id, std::string const& method) const {
+    runtime_type const* type = find(id);
+    return type != nullptr ? type->vtable[slot(method)] : nullptr;
+  }
+
+  std::size_t size() const { return types_.size(); }
+
+private:
+  // Finds a multiplier that maps every ID to a distinct bucket, growing the
+  // table when none can be found quickly.
+  void rehash() {
+    std::size_t bits = 1;
+    while ((std::size_t(1) << bits) < 2 * types_.size())
+      ++bits;
+    for (std::uint64_t state = 0; ; ++bits) {
+      for (int attempt = 0; attempt != 64; ++attempt) {
+        std::uint64_t const seed = next_seed(state) | 1;
+        if (try_build(seed, bits))
+          return;
+      }
+    }
+  }
+
+  bool try_build(std::uint64_t seed, std::size_t bits) {
+    std::vector<runtime_type const*> table(std::size_t(1) << bits, nullptr);
+    for (auto const& type : types_) {
+      auto& bucket = table[(type->id * seed) >> (64 - bits)];
+      if (bucket != nullptr)
+        return false;
+      bucket = type.get();
+    }
+    table_ = std::move(table);
+    seed_ = seed;
+    shift_ = 64 - bits;
+    return true;
+  }
+
+  static std::uint64_t next_seed(std::uint64_t& state) { // splitmix64
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  std::vector<std::string> methods_;
+  std::vector<std::unique_ptr<runtime_type>> types_;
+  std::vector<runtime_type const*> table_;
+  std::uint64_t seed_ = 1;
+  unsigned shift_ = 63;
+};
+
+// The function a plugin must define to register its types.
+extern "C" {
+  typedef void register_types_fn(type_registry& registry);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Loads a plugin and registers its types. The plugin is never unloaded,
+// since objects may still refer to its code.
+inline void load_plugin(type_registry& registry, char const* path) {
+  void* handle = ::dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr)
+    throw std::runtime_error{std::string{"unable to load plugin: "} +
+                             ::dlerror()};
+  void* symbol = ::dlsym(handle, "register_types");
+  if (symbol == nullptr)
+    throw std::runtime_error{std::string{path} + " is not a plugin"};
+  reinterpret_cast<register_types_fn*>(symbol)(registry);
+}
+#endif
+
+#endif // header guard
@@ -0,0 +1,186 @@
+// Copyright Louis Dionne 2017
+// Distributed under the Boost Software License, Version 1.0.
+
+#include "allocations.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// An existing hierarchy, which we'd like to migrate to value semantics
+// without rewriting all of it at once.
+// sample(LegacyVehicle)
+struct LegacyVehicle {
+  virtual void accelerate() = 0;
+  virtual ~LegacyVehicle() { }
+};
+// end-sample
+
+// Wraps types that are not part of the legacy hierarchy, so that everything
+// can be dispatched through the native vptr.
+template <typename T>
+struct VehicleModel final : LegacyVehicle {
+  explicit VehicleModel(T v) : vehicle{std::move(v)} { }
+  void accelerate() override { vehicle.accelerate(); }
+  T vehicle;
+};
+
+// The only operations that the legacy hierarchy doesn't provide virtually
+// are copying and moving, so that's all we need to put in our own vtable.
+// Destruction goes through the virtual destructor.
+struct copy_vtable {
+  LegacyVehicle* (*copy)(void* p, LegacyVehicle const* other);
+  LegacyVehicle* (*move)(void* p, LegacyVehicle* other);
+  LegacyVehicle* (*clone)(LegacyVehicle const* other);
+};
+
+template <typename T>
+copy_vtable const copy_vtable_for = {
+  [](void* p, LegacyVehicle const* other) -> LegacyVehicle* {
+    return new (p) T(*static_cast<T const*>(other));
+  },
+  [](void* p, LegacyVehicle* other) -> LegacyVehicle* {
+    return new (p) T(std::move(*static_cast<T*>(other)));
+  },
+  [](LegacyVehicle const* other) -> LegacyVehicle* {
+    return new T(*static_cast<T const*>(other));
+  }
+};
+
+// sample(Vehicle)
+class Vehicle {
+  copy_vtable const* vptr_;
+  LegacyVehicle* self_; // points to the object, wherever it's stored
+  std::aligned_storage_t<64> buffer_;
+  bool on_heap_;
+
+  // Types deriving from `LegacyVehicle` are stored as-is; other types are
+  // wrapped in a `VehicleModel` so they get a native vptr too.
+  template <typename Any>
+  using Stored = std::conditional_t<
+    std::is_base_of<LegacyVehicle, Any>::value,
+    Any,
+    VehicleModel<Any>
+  >;
+
+  template <typename T, typename Any>
+  void store(Any&& vehicle, std::true_type /* fits in the buffer */) {
+    on_heap_ = false;
+    self_ = new (&buffer_) T(std::move(vehicle));
+  }
+
+  template <typename T, typename Any>
+  void store(Any&& vehicle, std::false_type /* fits in the buffer */) {
+    on_heap_ = true;
+    self_ = new T(std::move(vehicle));
+  }
+
+public:
+  template <typename Any, typename T = Stored<Any>>
+  Vehicle(Any vehicle) : vptr_{&copy_vtable_for<T>} {
+    store<T>(std::move(vehicle),
+             std::integral_constant<bool, sizeof(T) <= sizeof(buffer_)>{});
+  }
+
+  void accelerate()
+  { self_->accelerate(); } // only one indirection: the native vptr
+// end-sample
+
+  Vehicle(Vehicle const& other)
+    : vptr_{other.vptr_}, on_heap_{other.on_heap_}
+  {
+    if (on_heap_) {
+      self_ = vptr_->clone(other.self_);
+    } else {
+      self_ = vptr_->copy(&buffer_, other.self_);
+    }
+  }
+
+  Vehicle(Vehicle&& other) noexcept
+    : vptr_{other.vptr_}, on_heap_{other.on_heap_}
+  {
+    if (on_heap_) {
+      self_ = other.self_;
+      other.self_ = nullptr;
+    } else {
+      self_ = vptr_->move(&buffer_, other.self_);
+    }
+  }
+
+  ~Vehicle() {
+    if (self_ == nullptr) // moved-from
+      return;
+    if (on_heap_) {
+      delete self_;
+    } else {
+      self_->~LegacyVehicle();
+    }
+  }
+// sample(Vehicle)
+};
+// end-sample
+
+
+//////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> accelerated;
+
+// A legacy vehicle, stored in the Vehicle directly.
+struct LegacyCar : LegacyVehicle {
+  LegacyCar(std::string make, int year) : make{make}, year{year} { }
+  void accelerate() override { accelerated.push_back("LegacyCar " + make); }
+  std::string make;
+  int year;
+};
+
+// New-style vehicles, which don't derive from anything.
+struct Truck {
+  std::string make;
+  int year;
+  void accelerate() { accelerated.push_back("Truck " + make); }
+};
+
+struct Plane {
+  std::string make;
+  std::string model;
+  void accelerate() { accelerated.push_back("Plane " + make); }
+};
+
+// sample(main)
+int main() {
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(3); // skip-sample
+
+  allocation_counter counter; // skip-sample
+  vehicles.push_back(LegacyCar{"Audi", 2017});
+  vehicles.push_back(Truck{"Chevrolet", 2015});
+  assert(counter.allocations() == 0); // skip-sample
+  vehicles.push_back(Plane{"Boeing", "747"}); // too large, goes on the heap
+  assert(counter.allocations() == 1); // skip-sample
+
+  for (auto& vehicle : vehicles) {
+    vehicle.accelerate();
+  }
+// end-sample
+
+  assert((accelerated == std::vector<std::string>{
+    "LegacyCar Audi", "Truck Chevrolet", "Plane Boeing"
+  }));
+
+  // Copies are deep, and keep dispatching through the copy's own vptr.
+  accelerated.clear();
+  std::vector<Vehicle> copies = vehicles;
+  copies.push_back(LegacyCar{"Toyota", 2012}); // reallocates, moving the rest
+  for (auto& vehicle : copies) {
+    vehicle.accelerate();
+  }
+  assert((accelerated == std::vector<std::string>{
+    "LegacyCar Audi", "Truck Chevrolet", "Plane Boeing", "LegacyCar Toyota"
+  }));
+// sample(main)
+}
+// end-sample
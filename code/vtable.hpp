@@ -5,6 +5,9 @@
 #define VTABLE_HPP
 
 #include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 
 // sample(vtable)
@@ -14,6 +17,8 @@ struct vtable {
   void* (*clone)(void const* this_);        // skip-sample
   void (*copy)(void* p, void const* other); // skip-sample
   void (*dtor)(void* p);                    // skip-sample
+  void (*move)(void* p, void* other);       // skip-sample
+  void (*dtor_n)(void* p, std::size_t n);   // skip-sample
 };
 
 template <typename T>
@@ -36,6 +41,17 @@ vtable const vtable_for = {
                                                   // skip-sample
   [](void* this_) {                               // skip-sample
     static_cast<T*>(this_)->~T();                 // skip-sample
+  },                                              // skip-sample
+                                                  // skip-sample
+  [](void* p, void* other) {                      // skip-sample
+    new (p) T(std::move(*static_cast<T*>(other)));// skip-sample
+  },                                              // skip-sample
+                                                  // skip-sample
+  [](void* p, std::size_t n) {                    // skip-sample
+    if (std::is_trivially_destructible<T>::value) // skip-sample
+      return;                                     // skip-sample
+    for (T* first = static_cast<T*>(p); n--; )    // skip-sample
+      (first++)->~T();                            // skip-sample
   }                                               // skip-sample
 };
 // end-sample